@@ -0,0 +1,58 @@
+// Times evaluating massless belt particles at each instruction set against the
+// same number of bodies in the double-precision KeplerOrbits used for planets,
+// and across the thread pool at the best instruction set.
+#include <cstdlib>
+#include <iostream>
+#include <random>
+
+#include "belt_particles.h"
+#include "bench_timing.h"
+#include "kepler.h"
+#include "thread_pool.h"
+
+int main(int argc, char **argv)
+{
+    std::size_t count = argc > 1 ? (std::size_t)std::atoll(argv[1]) : 2000000;
+    const int repeats = 5;
+
+    // An asteroid belt and a Kuiper belt of equal size, as in the application
+    BeltParticles belts;
+    belts.addBelt({count / 2, 11.0, 13.0, 0.2, 15.0, 14.0, 200.0, 0xff8090a0u, 1});
+    belts.addBelt({count - count / 2, 28.0, 36.0, 0.25, 25.0, 26.0, 2000.0, 0xffc0a080u, 2});
+
+    std::mt19937 rng(3);
+    std::uniform_real_distribution<double> uniform(0.0, 1.0);
+    KeplerOrbits orbits;
+    for (std::size_t i = 0; i < count; i++)
+    {
+        orbits.add({11.0 + 2.0 * uniform(rng), 0.2 * uniform(rng), 15.0 * uniform(rng), 360.0 * uniform(rng),
+                    360.0 * uniform(rng), 360.0 * uniform(rng), 200.0});
+    }
+
+    ThreadPool pool;
+    std::cout << "Particles: " << count << ", threads: " << pool.size() << std::endl;
+
+    double kepler = bestSeconds(repeats, [&](int r)
+                                { orbits.evaluate(100.0 + r); });
+    std::cout << "evaluator\tns/particle\tms" << std::endl;
+    std::cout << "KeplerOrbits\t" << kepler * 1e9 / count << "\t" << kepler * 1000.0 << std::endl;
+
+    const SimdLevel levels[] = {SimdLevel::Scalar, SimdLevel::AVX2, SimdLevel::AVX512};
+    for (SimdLevel level : levels)
+    {
+        belts.simdLevel = level;
+        if (belts.activeLevel() != level)
+        {
+            continue;
+        }
+        double seconds = bestSeconds(repeats, [&](int r)
+                                     { belts.evaluate(100.0 + r, 0, belts.size()); });
+        std::cout << "Belt " << simdLevelName(level) << "\t" << seconds * 1e9 / count << "\t" << seconds * 1000.0 << std::endl;
+    }
+
+    belts.simdLevel = SimdLevel::AVX512;
+    double parallel = bestSeconds(repeats, [&](int r)
+                                  { belts.evaluate(pool, 100.0 + r); });
+    std::cout << "Belt " << simdLevelName(belts.activeLevel()) << " pool\t" << parallel * 1e9 / count << "\t" << parallel * 1000.0 << std::endl;
+    return 0;
+}
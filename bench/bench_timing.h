@@ -0,0 +1,19 @@
+#pragma once
+
+#include <chrono>
+
+// Best wall time over a number of runs, in seconds. run is called with the
+// repeat number, for benchmarks that need fresh input each time.
+template <typename F>
+static double bestSeconds(int repeats, F &&run)
+{
+    double best = 1e30;
+    for (int r = 0; r < repeats; r++)
+    {
+        auto start = std::chrono::steady_clock::now();
+        run(r);
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        best = seconds < best ? seconds : best;
+    }
+    return best;
+}
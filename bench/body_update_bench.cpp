@@ -0,0 +1,166 @@
+// Compares per-body update throughput of the SoA BodyStore against the
+// pointer-based CelestialBody layout it replaced, and checks that the
+// level-parallel scheduler advances every body exactly once per tick.
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "body_store.h"
+#include "thread_pool.h"
+#include "update_scheduler.h"
+
+// The pre-SoA body layout: one heap allocation per body, children reached by pointer
+class LegacyBody
+{
+public:
+    std::string name;
+    float radius;
+    float distanceFromParent;
+    float orbitalPeriod;
+    float rotationPeriod;
+    float orbitalAngle;
+    float rotationAngle;
+    glm::vec3 color;
+    LegacyBody *parent;
+    std::vector<LegacyBody *> children;
+    unsigned int textureID;
+    bool useTexture;
+
+    LegacyBody(const std::string &n, float r, float dist, float orbPeriod, float rotPeriod, LegacyBody *p)
+        : name(n), radius(r), distanceFromParent(dist), orbitalPeriod(orbPeriod), rotationPeriod(rotPeriod),
+          orbitalAngle(0.0f), rotationAngle(0.0f), color(1.0f), parent(p), textureID(0), useTexture(true)
+    {
+        if (parent)
+        {
+            parent->children.push_back(this);
+        }
+    }
+
+    void update(float deltaTime)
+    {
+        if (orbitalPeriod > 0)
+        {
+            orbitalAngle += (360.0f / orbitalPeriod) * deltaTime * 0.5f;
+        }
+        if (rotationPeriod > 0)
+        {
+            rotationAngle += (360.0f / rotationPeriod) * deltaTime * 0.5f;
+        }
+        for (auto child : children)
+        {
+            child->update(deltaTime);
+        }
+    }
+};
+
+// Sun with planets, each planet carrying the same number of moons
+static void buildScene(int bodyCount, BodyStore &store, std::vector<LegacyBody *> &legacy)
+{
+    const int moonsPerPlanet = 9;
+    int sun = store.addBody(2.0f, 0.0f, 0.0f, 27.0f);
+    legacy.push_back(new LegacyBody("Sun", 2.0f, 0.0f, 0.0f, 27.0f, nullptr));
+
+    int planet = sun;
+    LegacyBody *legacyPlanet = legacy[0];
+    for (int i = 1; i < bodyCount; i++)
+    {
+        float period = 10.0f + (float)(i % 1000);
+        if ((i - 1) % (moonsPerPlanet + 1) == 0)
+        {
+            planet = store.addBody(0.1f, 4.0f + i * 0.001f, period, 1.0f, sun);
+            legacyPlanet = new LegacyBody("Planet", 0.1f, 4.0f + i * 0.001f, period, 1.0f, legacy[0]);
+            legacy.push_back(legacyPlanet);
+        }
+        else
+        {
+            store.addBody(0.02f, 0.5f, period * 0.1f, 1.0f, planet);
+            legacy.push_back(new LegacyBody("Moon", 0.02f, 0.5f, period * 0.1f, 1.0f, legacyPlanet));
+        }
+    }
+}
+
+template <typename F>
+static double updatesPerSecond(int bodyCount, F &&step)
+{
+    const int warmup = 5;
+    for (int i = 0; i < warmup; i++)
+    {
+        step();
+    }
+
+    int iterations = 0;
+    auto start = std::chrono::steady_clock::now();
+    double elapsed = 0.0;
+    while (elapsed < 1.0)
+    {
+        step();
+        iterations++;
+        elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+    return (double)bodyCount * iterations / elapsed;
+}
+
+// One scheduled tick must match one serial update of every body, bit for bit.
+// A body skipped or visited twice ends up with a different angle.
+static bool verifyExactlyOnce(const BodyStore &initial, UpdateScheduler &scheduler, int ticks)
+{
+    BodyStore serial = initial;
+    BodyStore scheduled = initial;
+    const float deltaTime = 1.0f / 60.0f;
+
+    for (int t = 0; t < ticks; t++)
+    {
+        serial.updateAll(deltaTime);
+        serial.updateWorldMatrices();
+        scheduler.tick(scheduled, deltaTime);
+
+        for (std::size_t i = 0; i < serial.size(); i++)
+        {
+            if (serial.orbitalAngle[i] != scheduled.orbitalAngle[i] ||
+                serial.rotationAngle[i] != scheduled.rotationAngle[i] ||
+                std::memcmp(&serial.worldMatrix[i], &scheduled.worldMatrix[i], sizeof(glm::mat4)) != 0)
+            {
+                std::cerr << "Body " << i << " was not updated exactly once on tick " << t << std::endl;
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+int main(int argc, char **argv)
+{
+    int bodyCount = argc > 1 ? std::atoi(argv[1]) : 100000;
+    const float deltaTime = 1.0f / 60.0f;
+
+    BodyStore store;
+    std::vector<LegacyBody *> legacy;
+    store.reserve(bodyCount);
+    buildScene(bodyCount, store, legacy);
+
+    // The legacy hierarchy is advanced from the root so every body updates exactly once
+    double legacyRate = updatesPerSecond(bodyCount, [&]() { legacy[0]->update(deltaTime); });
+    double soaRate = updatesPerSecond(bodyCount, [&]() { store.updateAll(deltaTime); });
+
+    ThreadPool pool;
+    UpdateScheduler scheduler(pool);
+    bool exactlyOnce = verifyExactlyOnce(store, scheduler, 3);
+    double scheduledRate = updatesPerSecond(bodyCount, [&]() { scheduler.tick(store, deltaTime); });
+
+    std::cout << "Bodies:            " << bodyCount << std::endl;
+    std::cout << "Pointer layout:    " << legacyRate / 1e6 << " M updates/s" << std::endl;
+    std::cout << "SoA BodyStore:     " << soaRate / 1e6 << " M updates/s" << std::endl;
+    std::cout << "Speedup:           " << soaRate / legacyRate << "x" << std::endl;
+    std::cout << "Scheduled tick:    " << scheduledRate / 1e6 << " M bodies/s (angles + world matrices, "
+              << pool.size() << " threads, " << scheduler.levelCount() << " levels)" << std::endl;
+    std::cout << "Exactly once:      " << (exactlyOnce ? "yes" : "NO") << std::endl;
+
+    for (auto body : legacy)
+    {
+        delete body;
+    }
+    return exactlyOnce ? 0 : 1;
+}
@@ -0,0 +1,79 @@
+// Times hierarchical frustum culling of a sun with many planets, each carrying
+// moons, against testing every body's own sphere on its own, and checks that
+// both agree on which bodies are visible.
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "bench_timing.h"
+#include "body_store.h"
+#include "frustum_culling.h"
+
+int main(int argc, char **argv)
+{
+    int planets = argc > 1 ? std::atoi(argv[1]) : 2000;
+    int moonsPerPlanet = argc > 2 ? std::atoi(argv[2]) : 16;
+    const int repeats = 20;
+
+    BodyStore store;
+    int sun = store.addBody(2.0f, 0.0, 0.0f, 27.0f);
+    for (int p = 0; p < planets; p++)
+    {
+        int planet = store.addBody(0.2f, 4.0 + 0.05 * p, 10.0f + p, 1.0f, sun, 137.5 * p);
+        for (int m = 0; m < moonsPerPlanet; m++)
+        {
+            store.addBody(0.1f, 2.0 + 0.3 * m, 1.0f + m, 1.0f, planet, 45.0 * m);
+        }
+    }
+    store.updateWorldMatrices();
+
+    // Camera just outside the orbits, looking in along -z, with a wide and a zoomed-in view
+    store.rebase(glm::dvec3(0.0, 5.0, 140.0));
+    glm::mat4 view = glm::lookAt(glm::vec3(0.0f), glm::vec3(0.0f, -0.1f, -1.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    std::cout << "Bodies: " << store.size() << " (" << planets << " planets, " << moonsPerPlanet << " moons each)" << std::endl;
+
+    bool agree = true;
+    const float fovs[] = {45.0f, 10.0f};
+    for (float fov : fovs)
+    {
+        glm::mat4 projection = glm::perspective(glm::radians(fov), 1.5f, 0.1f, 1000.0f);
+        Frustum frustum = Frustum::fromMatrix(projection * view);
+
+        FrustumCuller culler;
+        double hierarchical = bestSeconds(repeats, [&](int)
+                                          { culler.cull(store, frustum); });
+
+        // Reference: every body's own sphere against every plane
+        std::vector<int> flat;
+        double flatSeconds = bestSeconds(repeats, [&](int)
+                                         {
+            flat.clear();
+            for (std::size_t i = 0; i < store.size(); i++)
+            {
+                glm::vec3 center(store.renderMatrix[i][3]);
+                float radius = glm::length(glm::vec3(store.renderMatrix[i][1]));
+                bool inside = true;
+                for (const glm::vec4 &plane : frustum.planes)
+                {
+                    inside = inside && glm::dot(glm::vec3(plane), center) + plane.w >= -radius;
+                }
+                if (inside)
+                {
+                    flat.push_back((int)i);
+                }
+            } });
+
+        std::vector<int> visible = culler.visible;
+        std::sort(visible.begin(), visible.end());
+        agree = agree && visible == flat;
+
+        std::cout << "Field of view " << fov << ": visible " << culler.stats.visible << ", culled " << culler.stats.culled
+                  << ", systems culled " << culler.stats.systemsCulled << ", sphere tests " << culler.stats.sphereTests << std::endl;
+        std::cout << "  hierarchical " << hierarchical * 1e6 << " us, per body " << flatSeconds * 1e6 << " us, same result: "
+                  << (visible == flat ? "yes" : "no") << std::endl;
+    }
+    return agree ? 0 : 1;
+}
@@ -0,0 +1,76 @@
+// Measures the direct-summation kernels at every instruction set this CPU
+// supports, in both precisions: interactions per second per core, GFLOP/s and
+// the worst relative force error against the scalar double-precision kernel.
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+#include "direct_solver.h"
+#include "particle_system.h"
+#include "thread_pool.h"
+
+// Conventional count for one softened interaction (3 sub, 6 mul/add for r^2,
+// rsqrt counted as 2, 3 mul, 6 for the accumulation), as used for GRAPE and GPU kernels
+const double flopsPerInteraction = 20.0;
+
+int main(int argc, char **argv)
+{
+    std::size_t count = argc > 1 ? (std::size_t)std::atoll(argv[1]) : 16384;
+    int repeats = argc > 2 ? std::atoi(argv[2]) : 3;
+
+    ThreadPool pool;
+    ParticleSystem particles;
+    createPlummerSphere(particles, count, 1.0, 1.0, 1.0, 42);
+
+    DirectSolver solver(pool);
+    std::cout << "Particles: " << count << ", threads: " << pool.size()
+              << ", best instruction set: " << simdLevelName(detectSimdLevel()) << std::endl;
+
+    // Reference accelerations
+    solver.simdLevel = SimdLevel::Scalar;
+    solver.computeForces(particles);
+    std::vector<double> referenceX(particles.ax.begin(), particles.ax.end());
+    std::vector<double> referenceY(particles.ay.begin(), particles.ay.end());
+    std::vector<double> referenceZ(particles.az.begin(), particles.az.end());
+
+    std::cout << "kernel    precision  Minteractions/s/core  GFLOP/s  max rel error" << std::endl;
+    const SimdLevel levels[] = {SimdLevel::Scalar, SimdLevel::SSE42, SimdLevel::AVX2, SimdLevel::AVX512};
+    for (SimdLevel level : levels)
+    {
+        solver.simdLevel = level;
+        if (solver.activeLevel() != level)
+        {
+            continue;
+        }
+
+        for (int single = 0; single < 2; single++)
+        {
+            solver.singlePrecision = single != 0;
+
+            double best = 1e30;
+            for (int r = 0; r < repeats; r++)
+            {
+                solver.computeForces(particles);
+                best = std::min(best, solver.lastTimings.forceSeconds);
+            }
+
+            double worstError = 0.0;
+            for (std::size_t i = 0; i < count; i++)
+            {
+                double dx = particles.ax[i] - referenceX[i];
+                double dy = particles.ay[i] - referenceY[i];
+                double dz = particles.az[i] - referenceZ[i];
+                double reference = std::sqrt(referenceX[i] * referenceX[i] + referenceY[i] * referenceY[i] + referenceZ[i] * referenceZ[i]);
+                worstError = std::max(worstError, std::sqrt(dx * dx + dy * dy + dz * dz) / reference);
+            }
+
+            double rate = solver.lastInteractions / best;
+            std::cout << simdLevelName(level) << "\t" << (single ? "float" : "double") << "\t"
+                      << rate / pool.size() * 1e-6 << "\t" << rate * flopsPerInteraction * 1e-9 << "\t"
+                      << worstError << std::endl;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,114 @@
+// Sweeps the FMM expansion order on a Plummer sphere and reports time and
+// force error against exact direct summation on a sample of particles, then
+// names the cheapest order whose mean error meets the target. A Barnes-Hut row
+// at its default opening angle is included for comparison.
+//
+// Arguments: particle count, opening angle, error target, softening, leaf size
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+#include "barnes_hut.h"
+#include "fmm_solver.h"
+#include "particle_system.h"
+#include "thread_pool.h"
+
+struct ErrorStats
+{
+    double mean;
+    double percentile99;
+};
+
+static ErrorStats forceError(const ParticleSystem &particles, const std::vector<std::size_t> &sample,
+                             const std::vector<glm::dvec3> &exact)
+{
+    std::vector<double> errors;
+    double sum = 0.0;
+    for (std::size_t s = 0; s < sample.size(); s++)
+    {
+        std::size_t i = sample[s];
+        glm::dvec3 approx(particles.ax[i], particles.ay[i], particles.az[i]);
+        double error = glm::length(approx - exact[s]) / glm::length(exact[s]);
+        errors.push_back(error);
+        sum += error;
+    }
+    std::sort(errors.begin(), errors.end());
+    return {sum / errors.size(), errors[(std::size_t)(0.99 * (errors.size() - 1))]};
+}
+
+int main(int argc, char **argv)
+{
+    std::size_t count = argc > 1 ? (std::size_t)std::atoll(argv[1]) : 100000;
+    double theta = argc > 2 ? std::atof(argv[2]) : 0.7;
+    double target = argc > 3 ? std::atof(argv[3]) : 1e-3;
+    double eps = argc > 4 ? std::atof(argv[4]) : 0.01;
+    int leafSize = argc > 5 ? std::atoi(argv[5]) : 64;
+    const double G = 1.0;
+
+    ThreadPool pool;
+    ParticleSystem particles;
+    createPlummerSphere(particles, count, 1.0, 1.0, G, 42);
+
+    // Exact softened accelerations on a sample
+    const std::size_t samples = 500;
+    std::vector<std::size_t> sample;
+    std::vector<glm::dvec3> exact;
+    for (std::size_t s = 0; s < samples; s++)
+    {
+        std::size_t i = s * (count / samples);
+        glm::dvec3 acc(0.0);
+        for (std::size_t j = 0; j < count; j++)
+        {
+            glm::dvec3 d(particles.x[j] - particles.x[i], particles.y[j] - particles.y[i], particles.z[j] - particles.z[i]);
+            double r2 = glm::dot(d, d) + eps * eps;
+            acc += d * (G * particles.mass[j] / (r2 * std::sqrt(r2)));
+        }
+        sample.push_back(i);
+        exact.push_back(acc);
+    }
+
+    std::cout << "Particles: " << count << ", opening angle: " << theta << ", threads: " << pool.size()
+              << ", error target: " << target << std::endl;
+    std::cout << "solver  order  build(ms)  force(ms)  M2L  direct pairs  mean error  99% error" << std::endl;
+
+    BarnesHutSolver tree(pool);
+    tree.softening = eps;
+    tree.computeForces(particles);
+    ErrorStats treeError = forceError(particles, sample, exact);
+    std::cout << "BH\t-\t" << tree.lastTimings.buildSeconds * 1e3 << "\t" << tree.lastTimings.forceSeconds * 1e3
+              << "\t-\t-\t" << treeError.mean << "\t" << treeError.percentile99 << std::endl;
+
+    FmmSolver fmm(pool);
+    fmm.openingAngle = theta;
+    fmm.softening = eps;
+    fmm.leafSize = leafSize;
+
+    const int maxOrder = 8;
+    int cheapestOrder = -1;
+    double cheapestTime = 0.0;
+    for (int order = 1; order <= maxOrder; order++)
+    {
+        fmm.expansionOrder = order;
+        fmm.computeForces(particles);
+        ErrorStats error = forceError(particles, sample, exact);
+        double seconds = fmm.lastTimings.buildSeconds + fmm.lastTimings.forceSeconds;
+
+        std::cout << "FMM\t" << order << "\t" << fmm.lastTimings.buildSeconds * 1e3 << "\t" << fmm.lastTimings.forceSeconds * 1e3
+                  << "\t" << fmm.lastMultipoleToLocal << "\t" << fmm.lastParticlePairs << "\t" << error.mean
+                  << "\t" << error.percentile99 << std::endl;
+
+        if (error.mean <= target && (cheapestOrder < 0 || seconds < cheapestTime))
+        {
+            cheapestOrder = order;
+            cheapestTime = seconds;
+        }
+    }
+
+    if (cheapestOrder >= 0)
+        std::cout << "Cheapest order meeting the target: " << cheapestOrder << " (" << cheapestTime * 1e3 << " ms)" << std::endl;
+    else
+        std::cout << "No order up to " << maxOrder << " meets the target at this opening angle" << std::endl;
+    return 0;
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include <iostream>
+
+// An OpenGL 3.3 core context on GLFW's null platform, as the application's
+// --headless mode uses; Mesa's llvmpipe runs it on the CPU. There is no
+// default framebuffer, so draws need an OffscreenTarget bound. Null (after
+// reporting why) if no context could be made; call glfwTerminate() when done.
+static GLFWwindow *createHeadlessContext(const char *name)
+{
+    glfwInitHint(GLFW_PLATFORM, GLFW_PLATFORM_NULL);
+    if (!glfwInit())
+    {
+        std::cerr << "Failed to initialize GLFW" << std::endl;
+        return nullptr;
+    }
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+    glfwWindowHint(GLFW_CONTEXT_CREATION_API, GLFW_EGL_CONTEXT_API);
+    GLFWwindow *window = glfwCreateWindow(64, 64, name, NULL, NULL);
+    if (!window)
+    {
+        std::cerr << "Failed to create an OpenGL 3.3 context" << std::endl;
+        glfwTerminate();
+        return nullptr;
+    }
+    glfwMakeContextCurrent(window);
+    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
+    {
+        std::cerr << "Failed to initialize GLAD" << std::endl;
+        glfwTerminate();
+        return nullptr;
+    }
+    return window;
+}
@@ -0,0 +1,88 @@
+// Integrates a swarm of light planetesimals around a central star with each
+// integrator at several step sizes and reports force evaluations, worst
+// relative energy error and run time, so accuracy can be compared per force
+// evaluation spent.
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+
+#include "barnes_hut.h"
+#include "integrator.h"
+#include "particle_system.h"
+#include "thread_pool.h"
+
+// Planetesimals on near-circular, slightly inclined orbits between radius 1 and 3
+// around a unit central mass (G = 1, so the orbital period at radius 1 is 2 pi)
+static void createSwarm(ParticleSystem &particles, std::size_t count, double particleMass, unsigned seed)
+{
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<double> uniform(0.0, 1.0);
+
+    particles.clear();
+    particles.reserve(count);
+    for (std::size_t i = 0; i < count; i++)
+    {
+        double a = 1.0 + 2.0 * uniform(rng);
+        double e = 0.1 * uniform(rng);
+        double inc = 0.05 * (uniform(rng) - 0.5);
+        double phase = 6.28318530717958647692 * uniform(rng);
+
+        // Start at periapsis, where the speed is sqrt((1 + e) / (a (1 - e)))
+        double r = a * (1.0 - e);
+        double speed = std::sqrt((1.0 + e) / r);
+        glm::dvec3 position(r * std::cos(phase), r * std::sin(phase) * std::cos(inc), r * std::sin(phase) * std::sin(inc));
+        glm::dvec3 velocity(-speed * std::sin(phase), speed * std::cos(phase) * std::cos(inc), speed * std::cos(phase) * std::sin(inc));
+        particles.add(position, velocity, particleMass);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    std::size_t count = argc > 1 ? (std::size_t)std::atoll(argv[1]) : 1000;
+    double orbits = argc > 2 ? std::atof(argv[2]) : 5.0;
+    const double duration = orbits * 6.28318530717958647692;
+
+    ThreadPool pool;
+    BarnesHutSolver solver(pool);
+    solver.softening = 1e-3;
+
+    std::cout << "Planetesimals: " << count << ", duration: " << orbits << " inner orbits, threads: " << pool.size() << std::endl;
+    std::cout << "method         step     force evals  max |dE/E0|  seconds" << std::endl;
+
+    const IntegratorMethod methods[] = {IntegratorMethod::Leapfrog, IntegratorMethod::Yoshida4, IntegratorMethod::WisdomHolman};
+    const double steps[] = {0.01, 0.05, 0.2};
+
+    for (IntegratorMethod method : methods)
+    {
+        for (double dt : steps)
+        {
+            ParticleSystem particles;
+            createSwarm(particles, count, 1e-7, 7);
+
+            FixedStepIntegrator integrator(solver);
+            integrator.method = method;
+            integrator.timeStep = dt;
+            integrator.centralMass = 1.0;
+
+            solver.computeForces(particles);
+            double initialEnergy = integrator.energy(particles);
+            double worstError = 0.0;
+
+            auto start = std::chrono::steady_clock::now();
+            int stepCount = (int)std::ceil(duration / dt);
+            for (int step = 0; step < stepCount; step++)
+            {
+                integrator.step(particles);
+                double error = std::fabs((integrator.energy(particles) - initialEnergy) / initialEnergy);
+                worstError = std::max(worstError, error);
+            }
+            double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+            std::cout << integratorName(method) << "\t" << dt << "\t" << integrator.forceEvaluations() << "\t" << worstError
+                      << "\t" << seconds << std::endl;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,75 @@
+// Steps a Plummer star cluster with the Barnes-Hut solver and reports tree
+// build time, force time and relative energy error for every step, plus the
+// force error against exact direct summation on a sample of particles.
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+
+#include "barnes_hut.h"
+#include "integrator.h"
+#include "particle_system.h"
+#include "thread_pool.h"
+
+// Exact acceleration on particle i by summing over every other particle
+static glm::dvec3 directAcceleration(const ParticleSystem &particles, std::size_t i, double G, double eps)
+{
+    glm::dvec3 acc(0.0);
+    for (std::size_t j = 0; j < particles.size(); j++)
+    {
+        if (j == i)
+            continue;
+        glm::dvec3 d(particles.x[j] - particles.x[i], particles.y[j] - particles.y[i], particles.z[j] - particles.z[i]);
+        double r2 = glm::dot(d, d) + eps * eps;
+        acc += d * (G * particles.mass[j] / (r2 * std::sqrt(r2)));
+    }
+    return acc;
+}
+
+int main(int argc, char **argv)
+{
+    std::size_t count = argc > 1 ? (std::size_t)std::atoll(argv[1]) : 100000;
+    double theta = argc > 2 ? std::atof(argv[2]) : 0.5;
+    int steps = argc > 3 ? std::atoi(argv[3]) : 10;
+    const double dt = 1.0 / 128.0;
+
+    ThreadPool pool;
+    ParticleSystem particles;
+    createPlummerSphere(particles, count, 1.0, 1.0, 1.0, 42);
+
+    BarnesHutSolver solver(pool);
+    solver.openingAngle = theta;
+    solver.softening = 0.01;
+    FixedStepIntegrator integrator(solver);
+    integrator.timeStep = dt;
+
+    solver.computeForces(particles);
+    double initialEnergy = particles.totalEnergy();
+
+    std::cout << "Particles: " << count << ", opening angle: " << theta << ", threads: " << pool.size()
+              << ", nodes: " << solver.nodeCount() << std::endl;
+
+    // Median relative force error on a sample
+    const std::size_t samples = 200;
+    double errorSum = 0.0, worstError = 0.0;
+    for (std::size_t s = 0; s < samples; s++)
+    {
+        std::size_t i = s * (count / samples);
+        glm::dvec3 exact = directAcceleration(particles, i, solver.gravitationalConstant, solver.softening);
+        glm::dvec3 approx(particles.ax[i], particles.ay[i], particles.az[i]);
+        double error = glm::length(approx - exact) / glm::length(exact);
+        errorSum += error;
+        worstError = std::max(worstError, error);
+    }
+    std::cout << "Force error: mean " << errorSum / samples << ", worst " << worstError << std::endl;
+
+    std::cout << "step  build(ms)  force(ms)  |dE/E0|" << std::endl;
+    for (int step = 1; step <= steps; step++)
+    {
+        integrator.step(particles);
+        double energy = particles.totalEnergy();
+        std::cout << step << "  " << solver.lastTimings.buildSeconds * 1e3 << "  " << solver.lastTimings.forceSeconds * 1e3
+                  << "  " << std::fabs((energy - initialEnergy) / initialEnergy) << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,69 @@
+// Times the CPU side of per-body normal matrices: one glm inverse per body
+// against the uniform-scale kernel BodyStore uses. What this saves in the
+// vertex shader is measured under llvmpipe by VertexStageBench.
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "bench_timing.h"
+#include "normal_matrix.h"
+
+// Largest element difference from glm's inverse transpose
+static float maxError(const std::vector<glm::mat4> &models, const std::vector<glm::mat3> &normals)
+{
+    float worst = 0.0f;
+    for (std::size_t i = 0; i < models.size(); i++)
+    {
+        glm::mat3 expected = glm::transpose(glm::inverse(glm::mat3(models[i])));
+        for (int c = 0; c < 3; c++)
+        {
+            for (int r = 0; r < 3; r++)
+            {
+                float error = std::abs(normals[i][c][r] - expected[c][r]) / glm::length(expected[c]);
+                worst = error > worst ? error : worst;
+            }
+        }
+    }
+    return worst;
+}
+
+int main(int argc, char **argv)
+{
+    std::size_t count = argc > 1 ? (std::size_t)std::atoll(argv[1]) : 4096;
+    const int repeats = 5;
+
+    // Spinning, orbiting bodies of various sizes, as BodyStore produces
+    std::mt19937 rng(5);
+    std::uniform_real_distribution<float> uniform(0.0f, 1.0f);
+    std::vector<glm::mat4> uniformModels(count);
+    for (std::size_t i = 0; i < count; i++)
+    {
+        glm::mat4 model = glm::translate(glm::mat4(1.0f), glm::vec3(100.0f * uniform(rng), 0.0f, 100.0f * uniform(rng)));
+        model = glm::rotate(model, 6.28f * uniform(rng), glm::normalize(glm::vec3(uniform(rng), 1.0f, uniform(rng))));
+        uniformModels[i] = glm::scale(model, glm::vec3(0.05f + uniform(rng)));
+    }
+
+    std::vector<glm::mat3> normals(count);
+    volatile float sink = 0.0f;
+
+    std::cout << "Bodies: " << count << std::endl;
+    std::cout << "method\tns/body\tms" << std::endl;
+
+    double perBody = bestSeconds(repeats, [&](int)
+                                 {
+        for (std::size_t i = 0; i < count; i++)
+        {
+            normals[i] = glm::transpose(glm::inverse(glm::mat3(uniformModels[i])));
+        }
+        sink = normals[count / 2][0][0]; });
+    std::cout << "Per body glm\t" << perBody * 1e9 / count << "\t" << perBody * 1000.0 << std::endl;
+
+    double uniformScale = bestSeconds(repeats, [&](int)
+                                      { computeUniformScaleNormalMatrices(uniformModels.data(), count, normals.data()); });
+    std::cout << "Uniform scale\t" << uniformScale * 1e9 / count << "\t" << uniformScale * 1000.0
+              << "\t(max error " << maxError(uniformModels, normals) << ")" << std::endl;
+    return 0;
+}
@@ -0,0 +1,373 @@
+// Times the procedural body textures four ways. First each pattern alone, as
+// texels per second: a reference loop shaped like the one main() used to run,
+// comparing the body's name for every pixel and drawing white noise, against
+// the coherent noise pattern kernels at each instruction set. Then the nine textures of a
+// startup, one after another on one thread and in row tiles on thread pools of
+// growing size, and the same startup with a cold and a warm texture cache.
+// Last a full-resolution equirectangular Earth map on the pool.
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdlib>
+#include <filesystem>
+#include <future>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "bench_timing.h"
+#include "kernel_math.h"
+#include "procedural_texture.h"
+#include "texture_cache.h"
+#include "thread_pool.h"
+
+// White noise in [0, 0.99] for texel x of a row, drawn from a counter-based hash
+static float texelNoise(std::uint32_t rowKey, int x)
+{
+    std::uint32_t hash = pcgHash(rowKey + (std::uint32_t)x);
+    return (float)((hash >> 16) * 100u >> 16) / 100.0f;
+}
+
+// Reference loop with the structure main() used to have: the body's name is
+// compared for every pixel. Its white noise comes from the counter-based hash
+// rather than rand(), so it is not the old loop's output, only its shape.
+static void referenceTexture(const std::string &name, int size, unsigned char *pixels)
+{
+    const int width = size, height = size;
+    const std::uint32_t seed = textureSeed(name);
+
+    for (int y = 0; y < height; y++)
+    {
+        const std::uint32_t rowKey = pcgHash(pcgHash(seed) + (std::uint32_t)y);
+
+        for (int x = 0; x < width; x++)
+        {
+            std::size_t index = ((std::size_t)y * width + x) * 3;
+            float u = (float)x / width;
+            float v = (float)y / height;
+
+            if (name == "Sun")
+            {
+                // Sun texture - solar surface with granules and sunspots
+                float noise = texelNoise(rowKey, x);
+                float granule = sin(u * 50) * cos(v * 50) * 0.1f;
+
+                // Base solar color
+                int r = 255;
+                int g = 220 + (int)(noise * 35) + (int)(granule * 255);
+                int b = 150 + (int)(noise * 50);
+
+                // Add sunspots (dark regions)
+                float sunspot = sin(u * 3.14f) * sin(v * 2.1f);
+                if (sunspot > 0.8f && noise > 0.95f)
+                {
+                    r = 180;
+                    g = 150;
+                    b = 100;
+                }
+
+                pixels[index] = r;
+                pixels[index + 1] = g;
+                pixels[index + 2] = b;
+            }
+            else if (name == "Earth")
+            {
+                // Earth texture - continents, oceans, clouds
+                float noise = texelNoise(rowKey, x);
+                float continent = sin(u * 8) * cos(v * 6) + sin(u * 12) * cos(v * 9);
+
+                if (continent > 0.3f)
+                {
+                    // Land - green/brown continents
+                    pixels[index] = 50 + (int)(noise * 100);
+                    pixels[index + 1] = 120 + (int)(noise * 80);
+                    pixels[index + 2] = 50 + (int)(noise * 50);
+                }
+                else
+                {
+                    // Ocean - blue water
+                    pixels[index] = 20 + (int)(noise * 30);
+                    pixels[index + 1] = 80 + (int)(noise * 60);
+                    pixels[index + 2] = 150 + (int)(noise * 50);
+                }
+
+                // Add white clouds
+                if (noise > 0.85f)
+                {
+                    pixels[index] = 200;
+                    pixels[index + 1] = 200;
+                    pixels[index + 2] = 200;
+                }
+            }
+            else if (name == "Mars")
+            {
+                // Mars texture - red surface with craters and dust
+                float noise = texelNoise(rowKey, x);
+                float crater = sin(u * 20) * cos(v * 15) + sin(u * 30) * cos(v * 25);
+
+                // Base red surface
+                int r = 180 + (int)(noise * 40);
+                int g = 80 + (int)(noise * 30);
+                int b = 40 + (int)(noise * 20);
+
+                // Add craters (darker regions)
+                if (crater > 0.7f)
+                {
+                    r = 120;
+                    g = 50;
+                    b = 20;
+                }
+
+                pixels[index] = r;
+                pixels[index + 1] = g;
+                pixels[index + 2] = b;
+            }
+            else if (name == "Jupiter")
+            {
+                // Jupiter texture - gas giant with bands and storms
+                float band = sin(v * 20) * 0.5f + 0.5f;
+
+                // Alternating bands
+                if (band > 0.5f)
+                {
+                    pixels[index] = 200;
+                    pixels[index + 1] = 150;
+                    pixels[index + 2] = 100; // Light band
+                }
+                else
+                {
+                    pixels[index] = 160;
+                    pixels[index + 1] = 100;
+                    pixels[index + 2] = 60; // Dark band
+                }
+
+                // Add Great Red Spot
+                float redSpot = sqrt((u - 0.7f) * (u - 0.7f) + (v - 0.5f) * (v - 0.5f));
+                if (redSpot < 0.1f)
+                {
+                    pixels[index] = 180;
+                    pixels[index + 1] = 80;
+                    pixels[index + 2] = 60;
+                }
+            }
+            else if (name == "Saturn")
+            {
+                // Saturn texture - pale bands with subtle rings shadow
+                float band = sin(v * 15) * 0.3f + 0.7f;
+
+                pixels[index] = 200 + (int)(band * 30);
+                pixels[index + 1] = 180 + (int)(band * 20);
+                pixels[index + 2] = 140 + (int)(band * 20);
+            }
+            else if (name == "Uranus")
+            {
+                // Uranus texture - pale blue-green with subtle bands
+                float band = sin(v * 10) * 0.2f + 0.8f;
+
+                pixels[index] = 120 + (int)(band * 20);
+                pixels[index + 1] = 160 + (int)(band * 30);
+                pixels[index + 2] = 180 + (int)(band * 20);
+            }
+            else if (name == "Neptune")
+            {
+                // Neptune texture - deep blue with white clouds
+                float noise = texelNoise(rowKey, x);
+                float cloud = sin(u * 8) * cos(v * 6);
+
+                pixels[index] = 60 + (int)(noise * 20);
+                pixels[index + 1] = 100 + (int)(noise * 30);
+                pixels[index + 2] = 180 + (int)(noise * 40);
+
+                // Add white clouds
+                if (cloud > 0.8f && noise > 0.7f)
+                {
+                    pixels[index] = 200;
+                    pixels[index + 1] = 200;
+                    pixels[index + 2] = 200;
+                }
+            }
+            else
+            {
+                // Default texture for other planets
+                float noise = texelNoise(rowKey, x);
+                pixels[index] = 128 + (int)(noise * 127);
+                pixels[index + 1] = 128 + (int)(noise * 127);
+                pixels[index + 2] = 128 + (int)(noise * 127);
+            }
+        }
+    }
+}
+
+// Share of channels differing from the reference, and the largest difference
+static void compare(const std::vector<unsigned char> &reference, const std::vector<unsigned char> &pixels,
+                    double &differing, int &largest)
+{
+    std::size_t count = 0;
+    largest = 0;
+    for (std::size_t i = 0; i < reference.size(); i++)
+    {
+        int difference = std::abs((int)reference[i] - (int)pixels[i]);
+        count += difference != 0;
+        largest = difference > largest ? difference : largest;
+    }
+    differing = (double)count / (double)reference.size();
+}
+
+int main(int argc, char **argv)
+{
+    // Texture size, optionally the largest thread count (default: one per core)
+    // and the width of the Earth map (default 8192, 0 to skip it)
+    int size = argc > 1 ? std::atoi(argv[1]) : 512;
+    int mapWidth = argc > 3 ? std::atoi(argv[3]) : 8192;
+    const int repeats = size > 1024 ? 1 : 3;
+    const char *names[] = {"Sun", "Mercury", "Venus", "Earth", "Mars", "Jupiter", "Saturn", "Uranus", "Neptune"};
+
+    // Each pattern alone. The kernels draw different (coherent) noise from the
+    // reference loop, so they are compared with the scalar build instead, which every
+    // wider build must match exactly: the cache serves whichever one wrote it.
+    const double texels = (double)size * size;
+    std::cout << "pattern\tlevel\tMtexels/s\tspeedup\tdiffering\tmax diff" << std::endl;
+    const SimdLevel levels[] = {SimdLevel::Scalar, SimdLevel::AVX2, SimdLevel::AVX512};
+    for (const char *name : names)
+    {
+        std::vector<unsigned char> referencePixels((std::size_t)size * size * 3), scalar(referencePixels.size()), pixels(referencePixels.size());
+        double referenceSeconds = bestSeconds(repeats, [&](int)
+                                              { referenceTexture(name, size, referencePixels.data()); });
+        std::cout << name << "\treference\t" << texels / referenceSeconds * 1e-6 << "\t1\t-\t-" << std::endl;
+
+        for (SimdLevel level : levels)
+        {
+            if (textureSimdLevel(level) != level)
+            {
+                continue;
+            }
+            double seconds = bestSeconds(repeats, [&](int)
+                                         { generateProceduralTextureRows(texturePatternFor(name), textureSeed(name), size, size, 0,
+                                                                         size, pixels.data(), level); });
+            if (level == SimdLevel::Scalar)
+            {
+                scalar = pixels;
+            }
+            double differing;
+            int largest;
+            compare(scalar, pixels, differing, largest);
+            std::cout << name << "\t" << simdLevelName(level) << "\t" << texels / seconds * 1e-6 << "\t"
+                      << referenceSeconds / seconds << "\t" << differing * 100.0 << "%\t" << largest << std::endl;
+        }
+    }
+
+    std::cout << "Textures: 9 x " << size << "x" << size << std::endl;
+    // Textures are kept until all are done, as the queue keeps them
+    double serial = bestSeconds(repeats, [&](int)
+                                {
+                                    std::vector<std::vector<unsigned char>> textures;
+                                    for (const char *name : names)
+                                    {
+                                        textures.push_back(generateProceduralTexture(name, size));
+                                    }
+                                });
+    std::cout << "threads\tms\tspeedup" << std::endl;
+    std::cout << "serial\t" << serial * 1000.0 << "\t1" << std::endl;
+
+    // The serial result is the reference every pool size must reproduce exactly
+    std::vector<std::vector<unsigned char>> reference;
+    for (const char *name : names)
+    {
+        reference.push_back(generateProceduralTexture(name, size));
+    }
+
+    // Powers of two up to the core count, then the core count itself
+    std::vector<unsigned> threadCounts;
+    unsigned hardware = argc > 2 ? (unsigned)std::atoi(argv[2]) : ThreadPool().size();
+    for (unsigned threads = 1; threads < hardware; threads *= 2)
+    {
+        threadCounts.push_back(threads);
+    }
+    threadCounts.push_back(hardware);
+
+    for (unsigned threads : threadCounts)
+    {
+        ThreadPool pool(threads);
+        bool matches = true;
+        auto run = [&](bool check)
+        {
+            ProceduralTextureQueue queue(pool, size);
+            for (const char *name : names)
+            {
+                queue.add(name);
+            }
+            for (std::size_t i = 0; i < queue.size(); i++)
+            {
+                const MipChain &chain = queue.wait(i);
+                matches = matches && (!check || std::equal(reference[i].begin(), reference[i].end(), chain.data()));
+            }
+        };
+        run(true);
+        double seconds = bestSeconds(repeats, [&](int)
+                                     { run(false); });
+        std::cout << threads << "\t" << seconds * 1000.0 << "\t" << serial / seconds << (matches ? "" : "\tMISMATCH") << std::endl;
+    }
+
+    {
+        // The same startup against a texture cache: the first run generates and
+        // stores every texture with its mipmaps, later runs map them from disk
+        const std::string directory = "texture_bench_cache";
+        std::error_code ignored;
+        std::filesystem::remove_all(directory, ignored);
+        TextureCache cache(directory);
+        ThreadPool pool(hardware);
+        bool matches = true;
+        auto run = [&](int)
+        {
+            ProceduralTextureQueue queue(pool, size, &cache);
+            for (const char *name : names)
+            {
+                queue.add(name);
+            }
+            for (std::size_t i = 0; i < queue.size(); i++)
+            {
+                const MipChain &chain = queue.wait(i);
+                matches = matches && std::equal(reference[i].begin(), reference[i].end(), chain.data());
+            }
+        };
+        double cold = bestSeconds(1, run);
+        double warm = bestSeconds(repeats, run);
+        std::cout << "Texture cache: cold " << cold * 1000.0 << " ms, warm " << warm * 1000.0 << " ms ("
+                  << cache.hits << " hits, " << cache.misses << " misses)" << (matches ? "" : "\tMISMATCH") << std::endl;
+        std::filesystem::remove_all(directory, ignored);
+    }
+
+    if (mapWidth > 0)
+    {
+        // A 2:1 map in 64-row tiles, claimed by the workers and the calling thread
+        // alike the way ProceduralTextureQueue does, since a pool of one has no workers
+        const int mapHeight = mapWidth / 2, tileRows = 64;
+        ThreadPool pool(hardware);
+        std::vector<unsigned char> map((std::size_t)mapWidth * mapHeight * 3);
+        double seconds = bestSeconds(1, [&](int)
+                                     {
+                                         std::atomic<int> nextRow{0};
+                                         auto generateTiles = [&]()
+                                         {
+                                             for (int first; (first = nextRow.fetch_add(tileRows)) < mapHeight;)
+                                             {
+                                                 generateProceduralTextureRows(TexturePattern::Earth, textureSeed("Earth"), mapWidth, mapHeight,
+                                                                               first, std::min(mapHeight, first + tileRows), map.data());
+                                             }
+                                         };
+                                         std::vector<std::future<void>> tasks;
+                                         for (unsigned t = 1; t < pool.size(); t++)
+                                         {
+                                             tasks.push_back(pool.submit(generateTiles));
+                                         }
+                                         generateTiles();
+                                         for (std::future<void> &task : tasks)
+                                         {
+                                             task.get();
+                                         }
+                                     });
+        std::cout << "Earth map " << mapWidth << "x" << mapHeight << " on " << hardware << " threads: " << seconds
+                  << " s (" << (double)mapWidth * mapHeight / seconds * 1e-6 << " Mtexels/s)" << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,129 @@
+// Exercises TextureArrayPool under llvmpipe: layers handed out, freed (twice,
+// which must be harmless) and reused, and a size class overflowing into a
+// second array. Then times uploading whole mip chains into the pool's layers,
+// which is what startup does once the textures are generated or mapped.
+#include <cstdlib>
+#include <iostream>
+#include <set>
+#include <utility>
+#include <vector>
+
+#include "bench_timing.h"
+#include "headless_context.h"
+#include "kernel_math.h"
+#include "texture_array_pool.h"
+#include "texture_cache.h"
+
+// Reports a failed check; returns whether it passed
+static bool check(bool passed, const char *what)
+{
+    if (!passed)
+    {
+        std::cerr << "Pool check failed: " << what << std::endl;
+    }
+    return passed;
+}
+
+static bool checkPool()
+{
+    const int size = 64, layers = 4;
+    TextureArrayPool pool(layers);
+    bool passed = true;
+
+    // Filling the first array, then one more layer starts a second
+    std::vector<TextureSlot> slots;
+    for (int i = 0; i < layers; i++)
+    {
+        slots.push_back(pool.allocate(size));
+    }
+    passed &= check(pool.arrayCount() == 1 && pool.layersInUse(0) == layers, "one full array");
+    slots.push_back(pool.allocate(size));
+    passed &= check(pool.arrayCount() == 2 && slots.back().array == 1 && pool.layersInUse(1) == 1, "overflow to a second array");
+
+    // Another size class never shares an array
+    TextureSlot other = pool.allocate(size * 2);
+    passed &= check(other.array == 2 && pool.size(2) == size * 2, "separate size class");
+
+    // A freed layer is reused before the second array grows; freeing it twice changes nothing
+    TextureSlot freed = slots[1];
+    pool.free(freed);
+    pool.free(freed);
+    passed &= check(pool.layersInUse(0) == layers - 1, "double free ignored");
+    TextureSlot reused = pool.allocate(size);
+    passed &= check(reused.array == freed.array && reused.layer == freed.layer, "freed layer reused");
+    TextureSlot next = pool.allocate(size);
+    passed &= check(next.array == 1, "full array skipped");
+    slots[1] = reused;
+    slots.push_back(next);
+
+    // No two live slots share a layer
+    std::set<std::pair<int, int>> taken;
+    for (const TextureSlot &slot : slots)
+    {
+        taken.insert({slot.array, slot.layer});
+    }
+    passed &= check(taken.size() == slots.size(), "every layer handed out once");
+
+    // Freeing an empty slot does nothing
+    pool.free(TextureSlot());
+    passed &= check(pool.layersInUse(0) == layers && pool.layersInUse(1) == 2, "empty slot ignored");
+
+    pool.destroy();
+    return passed;
+}
+
+int main(int argc, char **argv)
+{
+    int size = argc > 1 ? std::atoi(argv[1]) : 1024;
+    int count = argc > 2 ? std::atoi(argv[2]) : 9;
+    const int repeats = 5;
+    if (size <= 0 || count <= 0)
+    {
+        std::cerr << "Usage: " << argv[0] << " [size] [textures]" << std::endl;
+        return 1;
+    }
+
+    if (!createHeadlessContext("TexturePoolBench"))
+    {
+        return 1;
+    }
+    std::cout << "Renderer: " << glGetString(GL_RENDERER) << std::endl;
+
+    bool passed = checkPool();
+    std::cout << "Pool checks: " << (passed ? "passed" : "FAILED") << std::endl;
+
+    // One noise texture with its mip chain, uploaded to every layer
+    MipChain chain;
+    chain.width = chain.height = size;
+    chain.offsets = mipLevelOffsets(size, size);
+    chain.pixels.resize(chain.offsets.back());
+    for (std::size_t i = 0; i < chain.offsets[1]; i++)
+    {
+        chain.pixels[i] = (unsigned char)(pcgHash((std::uint32_t)i) >> 24);
+    }
+    buildMipChain(size, size, chain.pixels.data());
+
+    TextureArrayPool pool;
+    std::vector<TextureSlot> slots;
+    for (int i = 0; i < count; i++)
+    {
+        slots.push_back(pool.allocate(size));
+    }
+    double seconds = bestSeconds(repeats, [&](int)
+                                 {
+        for (const TextureSlot &slot : slots)
+        {
+            for (int level = 0; level < chain.levels(); level++)
+            {
+                pool.uploadLevel(slot, level, chain.level(level));
+            }
+        }
+        glFinish(); });
+    std::cout << "Textures: " << count << " of " << size << "x" << size << " with " << chain.levels() << " levels in "
+              << pool.arrayCount() << " arrays" << std::endl;
+    std::cout << "Upload: " << seconds * 1000.0 << " ms, " << seconds * 1000.0 / count << " ms per texture" << std::endl;
+
+    pool.destroy();
+    glfwTerminate();
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,250 @@
+// Times the sphere vertex shader under Mesa's llvmpipe, which runs it on the
+// CPU: once inverting the model matrix at every vertex, as the shader used to,
+// and once reading the per-body normal matrix BodyStore now provides. Only the
+// vertex stage runs: every vertex is drawn once as a point into transform
+// feedback with rasterization off, so no fragment work is included.
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "bench_timing.h"
+#include "headless.h"
+#include "headless_context.h"
+#include "normal_matrix.h"
+#include "sphere_lod.h"
+
+static const char *vertexShaderSource = R"(
+    layout (location = 0) in vec3 aPos;
+    layout (location = 1) in vec3 aNormal;
+    layout (location = 2) in vec2 aTexCoord;
+    layout (location = 3) in mat4 model;
+    layout (location = 7) in mat3 normalMatrix;
+
+    uniform mat4 viewProjection;
+
+    out vec3 Normal;
+    out vec3 FragPos;
+    out vec2 TexCoord;
+
+    void main()
+    {
+        vec4 world = model * vec4(aPos, 1.0);
+        FragPos = world.xyz;
+#ifdef PER_VERTEX_INVERSE
+        Normal = mat3(transpose(inverse(model))) * aNormal;
+#else
+        Normal = normalMatrix * aNormal;
+#endif
+        TexCoord = aTexCoord;
+        gl_Position = viewProjection * world;
+    }
+)";
+
+static const char *fragmentShaderSource = R"(
+    #version 330 core
+    in vec3 Normal;
+    in vec3 FragPos;
+    in vec2 TexCoord;
+    out vec4 FragColor;
+
+    void main()
+    {
+        FragColor = vec4(Normal + FragPos, TexCoord.x);
+    }
+)";
+
+static GLuint compileShader(GLenum stage, const std::string &source)
+{
+    const char *text = source.c_str();
+    GLuint shader = glCreateShader(stage);
+    glShaderSource(shader, 1, &text, NULL);
+    glCompileShader(shader);
+
+    int success;
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+    if (!success)
+    {
+        char infoLog[512];
+        glGetShaderInfoLog(shader, 512, NULL, infoLog);
+        std::cerr << "Shader compilation failed\n" << infoLog << std::endl;
+    }
+    return shader;
+}
+
+// The sphere program, capturing the world-space normal of every vertex
+static GLuint linkProgram(bool perVertexInverse)
+{
+    std::string vertexSource = std::string("#version 330 core\n") +
+                               (perVertexInverse ? "#define PER_VERTEX_INVERSE\n" : "") + vertexShaderSource;
+    GLuint vertexShader = compileShader(GL_VERTEX_SHADER, vertexSource);
+    GLuint fragmentShader = compileShader(GL_FRAGMENT_SHADER, fragmentShaderSource);
+
+    GLuint program = glCreateProgram();
+    glAttachShader(program, vertexShader);
+    glAttachShader(program, fragmentShader);
+    const char *captured[] = {"Normal"};
+    glTransformFeedbackVaryings(program, 1, captured, GL_INTERLEAVED_ATTRIBS);
+    glLinkProgram(program);
+    glDeleteShader(vertexShader);
+    glDeleteShader(fragmentShader);
+
+    int success;
+    glGetProgramiv(program, GL_LINK_STATUS, &success);
+    if (!success)
+    {
+        char infoLog[512];
+        glGetProgramInfoLog(program, 512, NULL, infoLog);
+        std::cerr << "Program linking failed\n" << infoLog << std::endl;
+        return 0;
+    }
+    return program;
+}
+
+int main(int argc, char **argv)
+{
+    int count = argc > 1 ? std::atoi(argv[1]) : 1024;
+    const int repeats = 10;
+    if (count <= 0)
+    {
+        std::cerr << "Usage: " << argv[0] << " [bodies]" << std::endl;
+        return 1;
+    }
+
+    if (!createHeadlessContext("VertexStageBench"))
+    {
+        return 1;
+    }
+
+    // Drawing needs a framebuffer bound even with rasterization off
+    OffscreenTarget target(64, 64);
+    if (!target.complete())
+    {
+        std::cerr << "Failed to create an offscreen framebuffer" << std::endl;
+        glfwTerminate();
+        return 1;
+    }
+    target.bind();
+
+    // The sphere mesh the shader used to run on, and spinning, orbiting bodies of various sizes
+    std::vector<float> sphere = createSphereVertices(1.0f, 30, 30);
+    const int vertexCount = (int)sphere.size() / 8;
+
+    std::mt19937 rng(5);
+    std::uniform_real_distribution<float> uniform(0.0f, 1.0f);
+    std::vector<glm::mat4> models((std::size_t)count);
+    for (glm::mat4 &model : models)
+    {
+        model = glm::translate(glm::mat4(1.0f), glm::vec3(100.0f * uniform(rng), 0.0f, 100.0f * uniform(rng)));
+        model = glm::rotate(model, 6.28f * uniform(rng), glm::normalize(glm::vec3(uniform(rng), 1.0f, uniform(rng))));
+        model = glm::scale(model, glm::vec3(0.05f + uniform(rng)));
+    }
+    std::vector<glm::mat3> normals((std::size_t)count);
+    computeUniformScaleNormalMatrices(models.data(), models.size(), normals.data());
+
+    GLuint vao, sphereVbo, modelVbo, normalVbo, captureBuffer;
+    glGenVertexArrays(1, &vao);
+    glBindVertexArray(vao);
+
+    glGenBuffers(1, &sphereVbo);
+    glBindBuffer(GL_ARRAY_BUFFER, sphereVbo);
+    glBufferData(GL_ARRAY_BUFFER, sphere.size() * sizeof(float), sphere.data(), GL_STATIC_DRAW);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void *)0);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void *)(3 * sizeof(float)));
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void *)(6 * sizeof(float)));
+    glEnableVertexAttribArray(2);
+
+    // Per-instance model and normal matrices, one column per attribute
+    glGenBuffers(1, &modelVbo);
+    glBindBuffer(GL_ARRAY_BUFFER, modelVbo);
+    glBufferData(GL_ARRAY_BUFFER, models.size() * sizeof(glm::mat4), models.data(), GL_STATIC_DRAW);
+    for (GLuint column = 0; column < 4; column++)
+    {
+        glVertexAttribPointer(3 + column, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4), (void *)(column * sizeof(glm::vec4)));
+        glVertexAttribDivisor(3 + column, 1);
+        glEnableVertexAttribArray(3 + column);
+    }
+    glGenBuffers(1, &normalVbo);
+    glBindBuffer(GL_ARRAY_BUFFER, normalVbo);
+    glBufferData(GL_ARRAY_BUFFER, normals.size() * sizeof(glm::mat3), normals.data(), GL_STATIC_DRAW);
+    for (GLuint column = 0; column < 3; column++)
+    {
+        glVertexAttribPointer(7 + column, 3, GL_FLOAT, GL_FALSE, sizeof(glm::mat3), (void *)(column * sizeof(glm::vec3)));
+        glVertexAttribDivisor(7 + column, 1);
+        glEnableVertexAttribArray(7 + column);
+    }
+
+    // Room for the normal of every vertex of every body
+    const std::size_t capturedFloats = (std::size_t)count * vertexCount * 3;
+    glGenBuffers(1, &captureBuffer);
+    glBindBuffer(GL_TRANSFORM_FEEDBACK_BUFFER, captureBuffer);
+    glBufferData(GL_TRANSFORM_FEEDBACK_BUFFER, capturedFloats * sizeof(float), NULL, GL_STREAM_READ);
+    glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, captureBuffer);
+    glEnable(GL_RASTERIZER_DISCARD);
+
+    glm::mat4 viewProjection = glm::perspective(glm::radians(45.0f), 1.5f, 0.1f, 1000.0f) *
+                               glm::lookAt(glm::vec3(50.0f, 40.0f, -60.0f), glm::vec3(50.0f, 0.0f, 50.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+
+    std::cout << "Renderer: " << glGetString(GL_RENDERER) << std::endl;
+    std::cout << "Bodies: " << count << ", vertices per sphere: " << vertexCount << std::endl;
+    std::cout << "shader\tns/vertex\tms" << std::endl;
+
+    std::vector<float> reference(capturedFloats), captured(capturedFloats);
+    for (int variant = 0; variant < 2; variant++)
+    {
+        bool perVertexInverse = variant == 0;
+        GLuint program = linkProgram(perVertexInverse);
+        if (program == 0)
+        {
+            glfwTerminate();
+            return 1;
+        }
+        glUseProgram(program);
+        glUniformMatrix4fv(glGetUniformLocation(program, "viewProjection"), 1, GL_FALSE, &viewProjection[0][0]);
+
+        auto draw = [&](int)
+        {
+            glBeginTransformFeedback(GL_POINTS);
+            glDrawArraysInstanced(GL_POINTS, 0, vertexCount, count);
+            glEndTransformFeedback();
+            glFinish();
+        };
+
+        // The first draw also compiles the shader variant for this vertex layout
+        draw(0);
+        double seconds = bestSeconds(repeats, draw);
+        std::cout << (perVertexInverse ? "Per vertex inverse" : "Per body normal matrix") << "\t"
+                  << seconds * 1e9 / ((double)count * vertexCount) << "\t" << seconds * 1000.0;
+
+        // Both shaders must produce the same normals
+        glGetBufferSubData(GL_TRANSFORM_FEEDBACK_BUFFER, 0, capturedFloats * sizeof(float),
+                           perVertexInverse ? reference.data() : captured.data());
+        if (!perVertexInverse)
+        {
+            float worst = 0.0f;
+            for (std::size_t i = 0; i < capturedFloats; i++)
+            {
+                worst = std::fmax(worst, std::fabs(captured[i] - reference[i]));
+            }
+            std::cout << "\t(max normal difference " << worst << ")";
+        }
+        std::cout << std::endl;
+        glDeleteProgram(program);
+    }
+
+    glDeleteBuffers(1, &captureBuffer);
+    glDeleteBuffers(1, &normalVbo);
+    glDeleteBuffers(1, &modelVbo);
+    glDeleteBuffers(1, &sphereVbo);
+    glDeleteVertexArrays(1, &vao);
+    target.destroy();
+    glfwTerminate();
+    return 0;
+}
@@ -0,0 +1,306 @@
+#include "barnes_hut.h"
+#include "morton_order.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <functional>
+
+namespace
+{
+// Ranges larger than this at the top of the tree are built in parallel
+const int parallelBuildThreshold = 4096;
+const int maxParallelLevel = 3;
+
+// Independent accumulators in the force loop; small enough for compilers to
+// unroll the lane loop and map it onto SIMD registers
+const int lanes = 4;
+
+double secondsSince(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+}
+
+BarnesHutSolver::BarnesHutSolver(ThreadPool &pool) : pool(pool)
+{
+}
+
+void BarnesHutSolver::computeForces(ParticleSystem &particles)
+{
+    auto start = std::chrono::steady_clock::now();
+    const std::size_t n = particles.size();
+    if (n == 0)
+    {
+        nodes.clear();
+        lastTimings = Timings();
+        return;
+    }
+
+    glm::dvec3 low;
+    double extent = boundingCube(pool, particles, low);
+
+    sortParticles(particles, low, extent);
+    buildTree(extent);
+    lastTimings.buildSeconds = secondsSince(start);
+
+    start = std::chrono::steady_clock::now();
+    evaluate(particles);
+    lastTimings.forceSeconds = secondsSince(start);
+}
+
+void BarnesHutSolver::sortParticles(const ParticleSystem &particles, const glm::dvec3 &low, double extent)
+{
+    const std::size_t n = particles.size();
+    mortonSort(pool, particles, low, extent, codes, order);
+
+    sortedX.resize(n);
+    sortedY.resize(n);
+    sortedZ.resize(n);
+    sortedMass.resize(n);
+    pool.parallelFor(n, 16384, [&](std::size_t begin, std::size_t end)
+                     {
+        for (std::size_t k = begin; k < end; k++)
+        {
+            int i = order[k];
+            sortedX[k] = particles.x[i];
+            sortedY[k] = particles.y[i];
+            sortedZ[k] = particles.z[i];
+            sortedMass[k] = particles.mass[i];
+        } });
+}
+
+// Sum the children's monopoles into node index
+static void accumulateChildren(std::vector<BarnesHutSolver::Node> &out, int index)
+{
+    BarnesHutSolver::Node &node = out[index];
+    double mass = 0.0, x = 0.0, y = 0.0, z = 0.0;
+    for (int child = index + 1; child < node.next; child = out[child].next)
+    {
+        mass += out[child].mass;
+        x += out[child].mass * out[child].comX;
+        y += out[child].mass * out[child].comY;
+        z += out[child].mass * out[child].comZ;
+    }
+    node.mass = mass;
+    node.comX = mass > 0 ? x / mass : 0.0;
+    node.comY = mass > 0 ? y / mass : 0.0;
+    node.comZ = mass > 0 ? z / mass : 0.0;
+}
+
+void BarnesHutSolver::buildSubtree(std::vector<Node> &out, int begin, int end, int level, double size)
+{
+    int index = (int)out.size();
+    out.push_back(Node{0.0, 0.0, 0.0, 0.0, size, begin, end, 0, false});
+
+    if (end - begin <= leafSize || level >= mortonBits)
+    {
+        double mass = 0.0, x = 0.0, y = 0.0, z = 0.0;
+        for (int k = begin; k < end; k++)
+        {
+            mass += sortedMass[k];
+            x += sortedMass[k] * sortedX[k];
+            y += sortedMass[k] * sortedY[k];
+            z += sortedMass[k] * sortedZ[k];
+        }
+        Node &node = out[index];
+        node.leaf = true;
+        node.mass = mass;
+        node.comX = mass > 0 ? x / mass : sortedX[begin];
+        node.comY = mass > 0 ? y / mass : sortedY[begin];
+        node.comZ = mass > 0 ? z / mass : sortedZ[begin];
+        node.next = (int)out.size();
+        return;
+    }
+
+    int bounds[9];
+    int children = splitOctants(codes, begin, end, level, bounds);
+    for (int c = 0; c < children; c++)
+    {
+        buildSubtree(out, bounds[c], bounds[c + 1], level + 1, size * 0.5);
+    }
+
+    out[index].next = (int)out.size();
+    accumulateChildren(out, index);
+}
+
+void BarnesHutSolver::buildTree(double extent)
+{
+    // Large ranges near the root build their octants in parallel into separate
+    // arrays, which are then appended in depth-first order
+    std::function<std::vector<Node>(int, int, int, double)> buildTop =
+        [&](int begin, int end, int level, double size) -> std::vector<Node>
+    {
+        std::vector<Node> out;
+        if (end - begin < parallelBuildThreshold || level >= maxParallelLevel)
+        {
+            out.reserve((end - begin) / std::max(leafSize / 2, 1) + 1);
+            buildSubtree(out, begin, end, level, size);
+            return out;
+        }
+
+        int bounds[9];
+        int children = splitOctants(codes, begin, end, level, bounds);
+        std::vector<std::vector<Node>> parts(children);
+        pool.parallelFor(children, 1, [&](std::size_t first, std::size_t last)
+                         {
+            for (std::size_t c = first; c < last; c++)
+            {
+                parts[c] = buildTop(bounds[c], bounds[c + 1], level + 1, size * 0.5);
+            } });
+
+        out.push_back(Node{0.0, 0.0, 0.0, 0.0, size, begin, end, 0, false});
+        for (auto &part : parts)
+        {
+            int offset = (int)out.size();
+            for (Node &node : part)
+            {
+                node.next += offset;
+                out.push_back(node);
+            }
+        }
+        out[0].next = (int)out.size();
+        accumulateChildren(out, 0);
+        return out;
+    };
+
+    nodes = buildTop(0, (int)codes.size(), 0, extent);
+}
+
+void BarnesHutSolver::evaluate(ParticleSystem &particles)
+{
+    const double theta2 = openingAngle * openingAngle;
+    const double G = gravitationalConstant;
+    const int nodeTotal = (int)nodes.size();
+
+    const double selfSoftening = softeningLength();
+    const double eps2 = selfSoftening * selfSoftening;
+
+    // Each leaf is a group of nearby particles that share one tree walk
+    std::vector<int> leaves;
+    for (int i = 0; i < nodeTotal; i++)
+    {
+        if (nodes[i].leaf)
+        {
+            leaves.push_back(i);
+        }
+    }
+
+    pool.parallelFor(leaves.size(), 16, [&](std::size_t first, std::size_t last)
+                     {
+        // Interaction list: accepted cells and individual particles alike are point masses
+        AlignedVector<double> listX, listY, listZ, listMass;
+
+        for (std::size_t l = first; l < last; l++)
+        {
+            const Node &group = nodes[leaves[l]];
+
+            // Bounding sphere of the group
+            glm::dvec3 low(sortedX[group.begin], sortedY[group.begin], sortedZ[group.begin]);
+            glm::dvec3 high = low;
+            for (int k = group.begin; k < group.end; k++)
+            {
+                glm::dvec3 p(sortedX[k], sortedY[k], sortedZ[k]);
+                low = glm::min(low, p);
+                high = glm::max(high, p);
+            }
+            glm::dvec3 centre = 0.5 * (low + high);
+            double groupRadius = 0.5 * glm::length(high - low);
+
+            listX.clear();
+            listY.clear();
+            listZ.clear();
+            listMass.clear();
+
+            // Open a cell unless it is far enough from every point of the group
+            int current = 0;
+            while (current < nodeTotal)
+            {
+                const Node &node = nodes[current];
+                double distance = glm::length(glm::dvec3(node.comX, node.comY, node.comZ) - centre) - groupRadius;
+
+                // A cell holding the group is always opened, however wide the
+                // opening angle: the group's own particles must reach the list
+                // one by one for their self terms to cancel below
+                bool containsGroup = node.begin <= group.begin && group.end <= node.end;
+
+                if (!containsGroup && distance > 0 && node.size * node.size < theta2 * distance * distance)
+                {
+                    listX.push_back(node.comX);
+                    listY.push_back(node.comY);
+                    listZ.push_back(node.comZ);
+                    listMass.push_back(node.mass);
+                    current = node.next;
+                }
+                else if (node.leaf)
+                {
+                    for (int j = node.begin; j < node.end; j++)
+                    {
+                        listX.push_back(sortedX[j]);
+                        listY.push_back(sortedY[j]);
+                        listZ.push_back(sortedZ[j]);
+                        listMass.push_back(sortedMass[j]);
+                    }
+                    current = node.next;
+                }
+                else
+                {
+                    current++;
+                }
+            }
+
+            // Pad to a whole number of lanes with massless entries
+            while (listMass.size() % lanes != 0)
+            {
+                listX.push_back(0.0);
+                listY.push_back(0.0);
+                listZ.push_back(0.0);
+                listMass.push_back(0.0);
+            }
+
+            // Evaluate the list for every particle in the group. The particle's own
+            // entry is included: with softening it adds no force and a known
+            // potential, which is removed afterwards instead of branching in the
+            // loop. Each lane keeps its own partial sums, so the inner loop
+            // vectorizes without reassociating floating-point math.
+            const std::size_t listSize = listMass.size();
+            const double *lx = listX.data(), *ly = listY.data(), *lz = listZ.data(), *lm = listMass.data();
+            for (int k = group.begin; k < group.end; k++)
+            {
+                const double xi = sortedX[k], yi = sortedY[k], zi = sortedZ[k];
+                double laneX[lanes] = {}, laneY[lanes] = {}, laneZ[lanes] = {}, lanePhi[lanes] = {};
+
+                for (std::size_t j = 0; j < listSize; j += lanes)
+                {
+                    for (int lane = 0; lane < lanes; lane++)
+                    {
+                        double dx = lx[j + lane] - xi;
+                        double dy = ly[j + lane] - yi;
+                        double dz = lz[j + lane] - zi;
+                        double inv = 1.0 / std::sqrt(dx * dx + dy * dy + dz * dz + eps2);
+                        double mInv = lm[j + lane] * inv;
+                        double mInv3 = mInv * inv * inv;
+                        laneX[lane] += dx * mInv3;
+                        laneY[lane] += dy * mInv3;
+                        laneZ[lane] += dz * mInv3;
+                        lanePhi[lane] -= mInv;
+                    }
+                }
+
+                double accX = 0.0, accY = 0.0, accZ = 0.0, phi = sortedMass[k] / selfSoftening;
+                for (int lane = 0; lane < lanes; lane++)
+                {
+                    accX += laneX[lane];
+                    accY += laneY[lane];
+                    accZ += laneZ[lane];
+                    phi += lanePhi[lane];
+                }
+
+                int i = order[k];
+                particles.ax[i] = G * accX;
+                particles.ay[i] = G * accY;
+                particles.az[i] = G * accZ;
+                particles.potential[i] = G * phi;
+            }
+        } });
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include "gravity_solver.h"
+#include "thread_pool.h"
+
+#include <cstdint>
+#include <vector>
+
+// Barnes-Hut octree gravity. Particles are sorted along a Morton curve, the
+// tree is built over the sorted order with its top levels split across the
+// pool, and each leaf walks the tree once (stackless, depth-first) to build an
+// interaction list shared by all of its particles.
+class BarnesHutSolver : public GravitySolver
+{
+public:
+    // A cell of size s whose centre of mass is at distance d from the nearest
+    // point of a group is treated as a point mass when s / d < openingAngle
+    double openingAngle = 0.5;
+
+    // Particles per leaf before it is split
+    int leafSize = 16;
+
+    explicit BarnesHutSolver(ThreadPool &pool);
+
+    const char *name() const override { return "Barnes-Hut"; }
+    void computeForces(ParticleSystem &particles) override;
+
+    std::size_t nodeCount() const { return nodes.size(); }
+
+    struct Node
+    {
+        // Monopole: total mass and centre of mass
+        double mass;
+        double comX, comY, comZ;
+
+        // Edge length of the cell
+        double size;
+
+        // Particle range in Morton order
+        int begin, end;
+
+        // Index of the node after this subtree; children, if any, start at index + 1
+        int next;
+        bool leaf;
+    };
+
+private:
+    ThreadPool &pool;
+    std::vector<Node> nodes;
+
+    // Particle indices sorted by Morton code, with positions and masses gathered in that order
+    std::vector<std::uint64_t> codes;
+    std::vector<int> order;
+    AlignedVector<double> sortedX, sortedY, sortedZ, sortedMass;
+
+    void sortParticles(const ParticleSystem &particles, const glm::dvec3 &low, double extent);
+    void buildTree(double extent);
+    void buildSubtree(std::vector<Node> &out, int begin, int end, int level, double size);
+    void evaluate(ParticleSystem &particles);
+};
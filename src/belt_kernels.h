@@ -0,0 +1,78 @@
+#pragma once
+
+#include "kernel_math.h"
+
+#include <cstddef>
+
+// Belt propagation kernels for BeltParticles, one per instruction set. Each is
+// the same plain loop compiled in its own source file with that file's flags
+// and left to the auto-vectorizer. The helpers below are static so every file
+// keeps its own copy; like direct_kernels.h this header must stay free of
+// standard library calls, which the linker could share between the files.
+
+// Orbit arrays for a range of particles (see BeltParticles)
+struct BeltOrbitArrays
+{
+    const double *meanMotion;
+    const float *meanAnomalyAtEpoch, *eccentricity;
+    const float *px, *py, *pz;
+    const float *qx, *qy, *qz;
+    float *x, *y, *z;
+};
+
+// Evaluate count particles at the given time
+typedef void (*BeltKernel)(const BeltOrbitArrays &orbits, double time, std::size_t count);
+
+// Kernels; each returns null when its file was built without the instruction set
+BeltKernel scalarBeltKernel();
+BeltKernel avx2BeltKernel();
+BeltKernel avx512BeltKernel();
+
+// Newton steps after the e sin M starting guess; three reach float precision for e up to about 0.5
+static const int beltNewtonIterations = 3;
+
+// The loop shared by every kernel file. Restrict pointers let the compiler
+// vectorize all of it for the file's instruction set: every particle runs the
+// same fixed number of Newton steps.
+static inline void propagateBelt(double time, std::size_t count,
+                                 const double *__restrict meanMotion, const float *__restrict meanAnomalyAtEpoch,
+                                 const float *__restrict eccentricity,
+                                 const float *__restrict px, const float *__restrict py, const float *__restrict pz,
+                                 const float *__restrict qx, const float *__restrict qy, const float *__restrict qz,
+                                 float *__restrict x, float *__restrict y, float *__restrict z)
+{
+    const double twoPi = 6.28318530717958647692;
+    for (std::size_t i = 0; i < count; i++)
+    {
+        // Whole turns are removed in double; the rest fits a float comfortably
+        double phase = meanMotion[i] * time;
+        phase -= twoPi * roundToNearest(phase * (1.0 / twoPi));
+        float M = meanAnomalyAtEpoch[i] + (float)phase;
+        float e = eccentricity[i];
+
+        float s, c;
+        sinCos(M, s, c);
+        float E = M + e * s;
+        sinCos(E, s, c);
+
+        // Newton steps are small, so sin E and cos E are carried along by rotating
+        // through each step with short Taylor series instead of being recomputed
+        for (int iteration = 0; iteration < beltNewtonIterations; iteration++)
+        {
+            float step = (E - e * s - M) / (1.0f - e * c);
+            float step2 = step * step;
+            float sinStep = step * (1.0f - step2 * (1.0f / 6.0f - step2 * (1.0f / 120.0f)));
+            float cosStep = 1.0f - step2 * (0.5f - step2 * (1.0f / 24.0f));
+            E -= step;
+            float rotatedSin = s * cosStep - c * sinStep;
+            c = c * cosStep + s * sinStep;
+            s = rotatedSin;
+        }
+
+        // a (cos E - e) P + b sin E Q, with a and b already in P and Q
+        float xp = c - e;
+        x[i] = px[i] * xp + qx[i] * s;
+        y[i] = py[i] * xp + qy[i] * s;
+        z[i] = pz[i] * xp + qz[i] * s;
+    }
+}
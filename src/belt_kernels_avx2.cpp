@@ -0,0 +1,24 @@
+// Compiled with AVX2 and FMA enabled (see CMakeLists.txt)
+#include "belt_kernels.h"
+
+#if defined(__AVX2__)
+namespace
+{
+void evaluate(const BeltOrbitArrays &orbits, double time, std::size_t count)
+{
+    propagateBelt(time, count, orbits.meanMotion, orbits.meanAnomalyAtEpoch, orbits.eccentricity,
+                  orbits.px, orbits.py, orbits.pz, orbits.qx, orbits.qy, orbits.qz,
+                  orbits.x, orbits.y, orbits.z);
+}
+}
+
+BeltKernel avx2BeltKernel()
+{
+    return evaluate;
+}
+#else
+BeltKernel avx2BeltKernel()
+{
+    return nullptr;
+}
+#endif
@@ -0,0 +1,24 @@
+// Compiled with AVX-512F enabled (see CMakeLists.txt)
+#include "belt_kernels.h"
+
+#if defined(__AVX512F__)
+namespace
+{
+void evaluate(const BeltOrbitArrays &orbits, double time, std::size_t count)
+{
+    propagateBelt(time, count, orbits.meanMotion, orbits.meanAnomalyAtEpoch, orbits.eccentricity,
+                  orbits.px, orbits.py, orbits.pz, orbits.qx, orbits.qy, orbits.qz,
+                  orbits.x, orbits.y, orbits.z);
+}
+}
+
+BeltKernel avx512BeltKernel()
+{
+    return evaluate;
+}
+#else
+BeltKernel avx512BeltKernel()
+{
+    return nullptr;
+}
+#endif
@@ -0,0 +1,17 @@
+// Baseline build with the project's default flags (SSE2 on x86-64)
+#include "belt_kernels.h"
+
+namespace
+{
+void evaluate(const BeltOrbitArrays &orbits, double time, std::size_t count)
+{
+    propagateBelt(time, count, orbits.meanMotion, orbits.meanAnomalyAtEpoch, orbits.eccentricity,
+                  orbits.px, orbits.py, orbits.pz, orbits.qx, orbits.qy, orbits.qz,
+                  orbits.x, orbits.y, orbits.z);
+}
+}
+
+BeltKernel scalarBeltKernel()
+{
+    return evaluate;
+}
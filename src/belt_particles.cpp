@@ -0,0 +1,144 @@
+#include "belt_particles.h"
+#include "belt_kernels.h"
+
+#include <cmath>
+#include <random>
+
+namespace
+{
+const double twoPi = 6.28318530717958647692;
+const double toRadians = 3.14159265358979323846 / 180.0;
+
+// Particles per parallel chunk
+const std::size_t beltChunk = 16384;
+
+BeltKernel kernelFor(SimdLevel level)
+{
+    switch (level)
+    {
+    case SimdLevel::AVX512:
+        return avx512BeltKernel();
+    case SimdLevel::AVX2:
+        return avx2BeltKernel();
+    case SimdLevel::SSE42:
+        // Nothing in SSE4.2 helps this loop over the baseline build
+        return nullptr;
+    case SimdLevel::Scalar:
+        break;
+    }
+    return scalarBeltKernel();
+}
+
+bool available(SimdLevel level)
+{
+    return kernelFor(level) != nullptr && cpuSupports(level);
+}
+}
+
+SimdLevel BeltParticles::activeLevel() const
+{
+    SimdLevel level = simdLevel;
+    while (level != SimdLevel::Scalar && !available(level))
+    {
+        level = (SimdLevel)((int)level - 1);
+    }
+    return level;
+}
+
+void BeltParticles::addBelt(const BeltParameters &belt, double time)
+{
+    std::mt19937 rng(belt.seed);
+    std::uniform_real_distribution<double> uniform(0.0, 1.0);
+
+    const std::size_t first = size();
+    const std::size_t total = first + belt.count;
+    x.resize(total);
+    y.resize(total);
+    z.resize(total);
+    color.reserve(total);
+    meanMotion.reserve(total);
+    meanAnomalyAtEpoch.reserve(total);
+    eccentricity.reserve(total);
+    px.reserve(total);
+    py.reserve(total);
+    pz.reserve(total);
+    qx.reserve(total);
+    qy.reserve(total);
+    qz.reserve(total);
+
+    const double inner2 = belt.innerRadius * belt.innerRadius;
+    const double outer2 = belt.outerRadius * belt.outerRadius;
+
+    for (std::size_t i = 0; i < belt.count; i++)
+    {
+        // Uniform over the belt's area rather than its radius
+        double a = std::sqrt(inner2 + (outer2 - inner2) * uniform(rng));
+        double e = belt.maxEccentricity * uniform(rng);
+        double inc = belt.maxInclination * uniform(rng) * toRadians;
+        double node = twoPi * uniform(rng);
+        double peri = twoPi * uniform(rng);
+        double b = a * std::sqrt(1.0 - e * e);
+
+        // Same pace as KeplerOrbits: half a revolution per period of real time
+        double period = belt.referencePeriod * std::pow(a / belt.referenceRadius, 1.5);
+        meanMotion.push_back(0.5 * twoPi / period);
+        meanAnomalyAtEpoch.push_back((float)(twoPi * uniform(rng) - 0.5 * twoPi));
+        eccentricity.push_back((float)e);
+
+        // Perifocal basis in ecliptic coordinates, mapped to render space as (x, z, -y)
+        double cosNode = std::cos(node), sinNode = std::sin(node);
+        double cosPeri = std::cos(peri), sinPeri = std::sin(peri);
+        double cosInc = std::cos(inc), sinInc = std::sin(inc);
+
+        px.push_back((float)(a * (cosNode * cosPeri - sinNode * sinPeri * cosInc)));
+        py.push_back((float)(a * sinPeri * sinInc));
+        pz.push_back((float)(-a * (sinNode * cosPeri + cosNode * sinPeri * cosInc)));
+        qx.push_back((float)(b * (-cosNode * sinPeri - sinNode * cosPeri * cosInc)));
+        qy.push_back((float)(b * cosPeri * sinInc));
+        qz.push_back((float)(-b * (-sinNode * sinPeri + cosNode * cosPeri * cosInc)));
+
+        // Vary the brightness so the belt does not look flat
+        double brightness = 0.6 + 0.4 * uniform(rng);
+        std::uint32_t rgba = 0xff000000u;
+        for (int channel = 0; channel < 3; channel++)
+        {
+            std::uint32_t value = (belt.color >> (8 * channel)) & 0xffu;
+            rgba |= (std::uint32_t)(value * brightness) << (8 * channel);
+        }
+        color.push_back(rgba);
+    }
+
+    evaluate(time, first, total);
+}
+
+void BeltParticles::clear()
+{
+    x.clear();
+    y.clear();
+    z.clear();
+    color.clear();
+    meanMotion.clear();
+    meanAnomalyAtEpoch.clear();
+    eccentricity.clear();
+    px.clear();
+    py.clear();
+    pz.clear();
+    qx.clear();
+    qy.clear();
+    qz.clear();
+}
+
+void BeltParticles::evaluate(double time, std::size_t begin, std::size_t end)
+{
+    BeltOrbitArrays orbits = {meanMotion.data() + begin, meanAnomalyAtEpoch.data() + begin, eccentricity.data() + begin,
+                              px.data() + begin, py.data() + begin, pz.data() + begin,
+                              qx.data() + begin, qy.data() + begin, qz.data() + begin,
+                              x.data() + begin, y.data() + begin, z.data() + begin};
+    kernelFor(activeLevel())(orbits, time, end - begin);
+}
+
+void BeltParticles::evaluate(ThreadPool &pool, double time)
+{
+    pool.parallelFor(size(), beltChunk, [&](std::size_t begin, std::size_t end)
+                     { evaluate(time, begin, end); });
+}
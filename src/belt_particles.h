@@ -0,0 +1,67 @@
+#pragma once
+
+#include "aligned_allocator.h"
+#include "simd_level.h"
+#include "thread_pool.h"
+
+#include <cstddef>
+#include <cstdint>
+
+// Shape of one belt of particles. Distances and periods are in the same units
+// as OrbitalElements; angles are in degrees.
+struct BeltParameters
+{
+    std::size_t count;
+    double innerRadius, outerRadius;
+    double maxEccentricity;
+    double maxInclination;
+
+    // Periods follow Kepler's third law from an orbit of this radius and period,
+    // normally a neighbouring planet's
+    double referenceRadius, referencePeriod;
+
+    // Packed RGBA8, low byte red; each particle's brightness is varied a little
+    std::uint32_t color;
+    unsigned seed;
+};
+
+// Massless particles (asteroid and Kuiper belts) on analytic elliptical orbits
+// around one central body. They feel only the central body, so each position is
+// a closed-form function of time like KeplerOrbits, but stored in single
+// precision with the semi-axes folded into the orbit basis to keep millions of
+// them cheap to hold and evaluate. The evaluation loop is built for several
+// instruction sets and picked at run time, like the direct-summation kernels.
+class BeltParticles
+{
+public:
+    // Highest instruction set to use; lowered to what is available when evaluating
+    SimdLevel simdLevel = SimdLevel::AVX512;
+
+    // Positions relative to the central body in its scaled frame, in render coordinates (+Y up)
+    AlignedVector<float> x, y, z;
+
+    // Per-particle RGBA8, fixed when the particle is added
+    AlignedVector<std::uint32_t> color;
+
+    // Append a belt; positions are evaluated at the given time
+    void addBelt(const BeltParameters &belt, double time = 0.0);
+    void clear();
+    std::size_t size() const { return x.size(); }
+
+    // Evaluate particles [begin, end) at the given time (seconds since epoch)
+    void evaluate(double time, std::size_t begin, std::size_t end);
+    void evaluate(ThreadPool &pool, double time);
+
+    // Level actually used for the current setting of simdLevel
+    SimdLevel activeLevel() const;
+
+private:
+    // Mean motion stays in double so positions do not drift as time grows
+    AlignedVector<double> meanMotion;
+    AlignedVector<float> meanAnomalyAtEpoch;
+    AlignedVector<float> eccentricity;
+
+    // a P and b Q: the perifocal basis scaled by the semi-major and semi-minor axes
+    AlignedVector<float> px, py, pz;
+    AlignedVector<float> qx, qy, qz;
+};
@@ -0,0 +1,249 @@
+#include "body_store.h"
+#include "normal_matrix.h"
+
+#include <cassert>
+#include <cmath>
+
+int BodyStore::addBody(float r, double dist, float orbPeriod, float rotPeriod,
+                       int parentIndex, double initialOrbitalAngle)
+{
+    int index = (int)size();
+    assert(parentIndex < index);
+
+    orbitalAngle.push_back(initialOrbitalAngle);
+    orbitalAngleAtEpoch.push_back(initialOrbitalAngle);
+    rotationAngle.push_back(0.0f);
+    orbitalPeriod.push_back(orbPeriod);
+    rotationPeriod.push_back(rotPeriod);
+    distanceFromParent.push_back(dist);
+    radius.push_back(r);
+    parent.push_back(parentIndex);
+    depth.push_back(parentIndex != NoParent ? depth[parentIndex] + 1 : 0);
+
+    // Planets with longer periods move slower; the 0.5 keeps motion at a watchable pace
+    orbitalRate.push_back(orbPeriod > 0 ? (360.0 / orbPeriod) * 0.5 : 0.0);
+    rotationRate.push_back(rotPeriod > 0 ? (360.0f / rotPeriod) * 0.5f : 0.0f);
+
+    keplerOrbit.push_back(NoKeplerOrbit);
+    worldPosition.emplace_back(0.0);
+    worldMatrix.emplace_back(1.0f);
+    renderMatrix.emplace_back(1.0f);
+    normalMatrix.emplace_back(1.0f);
+
+    return index;
+}
+
+int BodyStore::addKeplerBody(float r, const OrbitalElements &elements, float rotPeriod, int parentIndex)
+{
+    // The circular orbit fields are kept for code that only needs a rough
+    // orbit size, but with a zero rate so the angle never advances
+    int index = addBody(r, elements.semiMajorAxis, (float)elements.period, rotPeriod, parentIndex);
+    orbitalRate[index] = 0.0;
+    keplerOrbit[index] = keplerOrbits.add(elements);
+    keplerOrbits.evaluate(simulationTime, keplerOrbit[index], keplerOrbit[index] + 1);
+    return index;
+}
+
+void BodyStore::reserve(std::size_t count)
+{
+    orbitalAngle.reserve(count);
+    orbitalAngleAtEpoch.reserve(count);
+    rotationAngle.reserve(count);
+    orbitalPeriod.reserve(count);
+    rotationPeriod.reserve(count);
+    distanceFromParent.reserve(count);
+    radius.reserve(count);
+    parent.reserve(count);
+    depth.reserve(count);
+    orbitalRate.reserve(count);
+    rotationRate.reserve(count);
+    keplerOrbit.reserve(count);
+    worldPosition.reserve(count);
+    worldMatrix.reserve(count);
+    renderMatrix.reserve(count);
+    normalMatrix.reserve(count);
+}
+
+void BodyStore::clear()
+{
+    orbitalAngle.clear();
+    orbitalAngleAtEpoch.clear();
+    rotationAngle.clear();
+    orbitalPeriod.clear();
+    rotationPeriod.clear();
+    distanceFromParent.clear();
+    radius.clear();
+    parent.clear();
+    depth.clear();
+    orbitalRate.clear();
+    rotationRate.clear();
+    keplerOrbit.clear();
+    worldPosition.clear();
+    worldMatrix.clear();
+    renderMatrix.clear();
+    normalMatrix.clear();
+    keplerOrbits.clear();
+    simulationTime = 0.0;
+}
+
+void BodyStore::updateAll(float deltaTime)
+{
+    simulationTime += deltaTime;
+    updateRange(deltaTime, 0, size());
+    keplerOrbits.evaluate(simulationTime);
+}
+
+void BodyStore::updateRange(float deltaTime, std::size_t begin, std::size_t end)
+{
+    double *__restrict orbit = orbitalAngle.data();
+    float *__restrict spin = rotationAngle.data();
+    const double *__restrict orbitRate = orbitalRate.data();
+    const float *__restrict spinRate = rotationRate.data();
+    const double orbitStep = deltaTime;
+
+    // Contiguous, independent lanes - the compiler vectorizes this loop
+    for (std::size_t i = begin; i < end; i++)
+    {
+        orbit[i] += orbitRate[i] * orbitStep;
+        spin[i] += spinRate[i] * deltaTime;
+    }
+}
+
+void BodyStore::seek(double time)
+{
+    simulationTime = time;
+
+    for (std::size_t i = 0; i < size(); i++)
+    {
+        // Wrap in double so large times do not lose the fractional revolution
+        orbitalAngle[i] = std::fmod(orbitalAngleAtEpoch[i] + orbitalRate[i] * time, 360.0);
+        rotationAngle[i] = (float)std::fmod((double)rotationRate[i] * time, 360.0);
+    }
+
+    keplerOrbits.evaluate(simulationTime);
+}
+
+// Local transform is rotate(orbit) * translate(distance) * rotate(spin) * scale(radius).
+// Both rotations are about +Y, so the rotation and scale collapse into a single
+// rotation by their sum; the translation is kept apart, in double.
+static inline glm::mat3 localLinear(const BodyStore &store, std::size_t i)
+{
+    const double toRadians = 3.14159265358979323846 / 180.0;
+
+    bool orbits = store.distanceFromParent[i] > 0;
+    double orbit = orbits ? store.orbitalAngle[i] * toRadians : 0.0;
+    float angle = (float)std::fmod(orbit + store.rotationAngle[i] * toRadians, 2.0 * 3.14159265358979323846);
+    float r = store.radius[i];
+    float c = std::cos(angle) * r;
+    float s = std::sin(angle) * r;
+
+    return glm::mat3(c, 0.0f, -s,
+                     0.0f, r, 0.0f,
+                     s, 0.0f, c);
+}
+
+static inline glm::dvec3 localOffset(const BodyStore &store, std::size_t i)
+{
+    const double toRadians = 3.14159265358979323846 / 180.0;
+
+    double d = store.distanceFromParent[i];
+    if (!(d > 0))
+    {
+        return glm::dvec3(0.0);
+    }
+    double orbit = store.orbitalAngle[i] * toRadians;
+    return glm::dvec3(d * std::cos(orbit), 0.0, -d * std::sin(orbit));
+}
+
+// Kepler orbits use the parent's origin and scale, like circular orbits, but
+// not its spin: an elliptical orbit stays fixed in space as the parent turns
+static inline void keplerTransform(const BodyStore &store, std::size_t i, glm::mat3 &linear, glm::dvec3 &position)
+{
+    const float toRadians = 3.14159265358979323846f / 180.0f;
+
+    glm::dvec3 origin(0.0);
+    double scale = 1.0;
+    if (store.parent[i] != BodyStore::NoParent)
+    {
+        origin = store.worldPosition[store.parent[i]];
+        scale = glm::length(glm::vec3(store.worldMatrix[store.parent[i]][1]));
+    }
+
+    int orbit = store.keplerOrbit[i];
+    position = origin + scale * glm::dvec3(store.keplerOrbits.positionX[orbit],
+                                           store.keplerOrbits.positionY[orbit],
+                                           store.keplerOrbits.positionZ[orbit]);
+
+    float angle = store.rotationAngle[i] * toRadians;
+    float r = store.radius[i] * (float)scale;
+    float c = std::cos(angle) * r;
+    float s = std::sin(angle) * r;
+
+    linear = glm::mat3(c, 0.0f, -s,
+                       0.0f, r, 0.0f,
+                       s, 0.0f, c);
+}
+
+// Parent rotation and scale compose in float; positions accumulate in double,
+// so float error only scales with the distance to the parent, never from the origin
+static inline void updateWorld(BodyStore &store, std::size_t i)
+{
+    glm::mat3 linear;
+    glm::dvec3 position;
+
+    if (store.keplerOrbit[i] != BodyStore::NoKeplerOrbit)
+    {
+        keplerTransform(store, i, linear, position);
+    }
+    else
+    {
+        linear = localLinear(store, i);
+        position = localOffset(store, i);
+        if (store.parent[i] != BodyStore::NoParent)
+        {
+            glm::mat3 parentLinear(store.worldMatrix[store.parent[i]]);
+            linear = parentLinear * linear;
+            position = store.worldPosition[store.parent[i]] + glm::dmat3(parentLinear) * position;
+        }
+    }
+
+    store.worldPosition[i] = position;
+    glm::mat4 &world = store.worldMatrix[i];
+    world = glm::mat4(linear);
+    world[3] = glm::vec4(glm::vec3(position), 1.0f);
+}
+
+void BodyStore::updateWorldMatrices()
+{
+    // Parents precede children, so their world matrix is already final
+    const std::size_t n = size();
+    for (std::size_t i = 0; i < n; i++)
+    {
+        updateWorld(*this, i);
+    }
+}
+
+void BodyStore::updateWorldMatrices(const int *indices, std::size_t count)
+{
+    for (std::size_t k = 0; k < count; k++)
+    {
+        updateWorld(*this, (std::size_t)indices[k]);
+    }
+}
+
+void BodyStore::rebase(const glm::dvec3 &origin)
+{
+    rebaseRange(origin, 0, size());
+}
+
+void BodyStore::rebaseRange(const glm::dvec3 &origin, std::size_t begin, std::size_t end)
+{
+    for (std::size_t i = begin; i < end; i++)
+    {
+        // Subtract in double first: the difference is small near the camera, where precision matters
+        renderMatrix[i] = worldMatrix[i];
+        renderMatrix[i][3] = glm::vec4(glm::vec3(worldPosition[i] - origin), 1.0f);
+    }
+    // Every body is a rotation times a uniform scale, so no inverse is needed
+    computeUniformScaleNormalMatrices(renderMatrix.data() + begin, end - begin, normalMatrix.data() + begin);
+}
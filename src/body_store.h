@@ -0,0 +1,97 @@
+#pragma once
+
+#include "aligned_allocator.h"
+#include "kepler.h"
+
+#include <glm/glm.hpp>
+#include <cstddef>
+
+// Structure-of-arrays storage for the kinematic state of every celestial body.
+// Bodies are addressed by index; a parent index of NoParent marks a root.
+//
+// Anything that decides where a body is (orbital angles, distances, world
+// positions) is kept in double so real astronomical distances stay exact.
+// Orientation and scale only need float. Rendering uses renderMatrix, which
+// rebase() fills with world matrices whose translation is taken relative to
+// the camera in double before being narrowed to float.
+class BodyStore
+{
+public:
+    static constexpr int NoParent = -1;
+    static constexpr int NoKeplerOrbit = -1;
+
+    AlignedVector<double> orbitalAngle;
+    AlignedVector<float> rotationAngle;
+    AlignedVector<float> orbitalPeriod;
+    AlignedVector<float> rotationPeriod;
+    AlignedVector<double> distanceFromParent;
+    AlignedVector<float> radius;
+    AlignedVector<int> parent;
+    AlignedVector<int> depth;
+
+    // Angular rates in degrees per second, precomputed from the periods so the
+    // update kernel is a branch-free multiply-add
+    AlignedVector<double> orbitalRate;
+    AlignedVector<float> rotationRate;
+
+    // Orbital angle at time zero, so seek() can place circular orbits in closed form
+    AlignedVector<double> orbitalAngleAtEpoch;
+
+    // Bodies on analytic elliptical orbits index into keplerOrbits; the rest
+    // hold NoKeplerOrbit and follow the circular orbitalAngle
+    AlignedVector<int> keplerOrbit;
+    KeplerOrbits keplerOrbits;
+
+    // Seconds of simulated time since the epoch
+    double simulationTime = 0.0;
+
+    // World position of every body, refreshed by updateWorldMatrices()
+    AlignedVector<glm::dvec3> worldPosition;
+
+    // World matrix of every body, refreshed by updateWorldMatrices(). The
+    // rotation and scale are exact; the translation is worldPosition narrowed
+    // to float, which is only good for rough placement far from the origin.
+    AlignedVector<glm::mat4> worldMatrix;
+
+    // World matrices relative to the origin given to rebase(); these go to the shaders
+    AlignedVector<glm::mat4> renderMatrix;
+
+    // Inverse transpose of each render matrix's upper 3x3, refreshed by rebase()
+    AlignedVector<glm::mat3> normalMatrix;
+
+    // Returns the index of the new body. Parents must be added before children,
+    // which keeps the arrays sorted so a single forward pass sees every parent
+    // before any of its descendants.
+    int addBody(float r, double dist, float orbPeriod, float rotPeriod,
+                int parentIndex = NoParent, double initialOrbitalAngle = 0.0);
+
+    // Add a body on an elliptical orbit around its parent. Like circular orbits
+    // it is measured in the parent's scaled frame, but it is not carried round
+    // by the parent's spin.
+    int addKeplerBody(float r, const OrbitalElements &elements, float rotPeriod,
+                      int parentIndex = NoParent);
+
+    void reserve(std::size_t count);
+    void clear();
+    std::size_t size() const { return radius.size(); }
+
+    // Advance every body's orbital and rotation angle by one time step
+    void updateAll(float deltaTime);
+    void updateRange(float deltaTime, std::size_t begin, std::size_t end);
+
+    // Jump straight to the given simulation time. Cost is independent of how
+    // far the jump is.
+    void seek(double time);
+
+    // Compute every world matrix exactly once, in index (parent-before-child) order
+    void updateWorldMatrices();
+
+    // Compute the world matrices of the listed bodies; their parents must already be up to date
+    void updateWorldMatrices(const int *indices, std::size_t count);
+
+    // Refresh renderMatrix for a new origin, normally the camera position, so
+    // bodies near the camera keep full float precision however far out they are.
+    // Also refreshes normalMatrix.
+    void rebase(const glm::dvec3 &origin);
+    void rebaseRange(const glm::dvec3 &origin, std::size_t begin, std::size_t end);
+};
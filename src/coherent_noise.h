@@ -0,0 +1,146 @@
+#pragma once
+
+#include "kernel_math.h"
+
+#include <cstdint>
+
+// Coherent noise for procedural surfaces: 3D simplex noise and the fBm, ridged
+// and domain-warped sums built from it. Every function is a branch-free scalar
+// function meant to be inlined into a kernel loop over texels, which the
+// auto-vectorizer then runs one texel per lane: 4 wide with NEON, 8 with AVX2,
+// 16 with AVX-512 (the x86 baseline build stays scalar, as SSE2 has no
+// per-lane shift for pcgHash). Lattice gradients are picked by hashing the cell
+// coordinates instead of indexing a permutation table, so no lane ever needs a
+// gather. Same rules as kernel_math.h: everything static, no standard library.
+// Octave counts are template arguments so the sums unroll into straight-line
+// code, and the functions are forced inline: a loop that calls one is never
+// vectorized, and a few octaves are past the size compilers inline on their own.
+
+#if defined(_MSC_VER)
+#define NOISE_INLINE static __forceinline
+#define NOISE_UNROLL
+#else
+#define NOISE_INLINE static inline __attribute__((always_inline))
+#define NOISE_UNROLL _Pragma("GCC unroll 16")
+#endif
+
+// Floor by rounding and stepping down where that rounded up
+NOISE_INLINE std::int32_t floorToInt(float x)
+{
+    float rounded = roundToNearest(x);
+    return (std::int32_t)rounded - (std::int32_t)(x < rounded);
+}
+
+// Hash of an integer lattice point
+NOISE_INLINE std::uint32_t latticeHash(std::int32_t i, std::int32_t j, std::int32_t k, std::uint32_t seed)
+{
+    return pcgHash(seed ^ ((std::uint32_t)i * 73856093u) ^ ((std::uint32_t)j * 19349663u) ^ ((std::uint32_t)k * 83492791u));
+}
+
+// Dot product of (x, y, z) with one of Perlin's twelve edge gradients, picked by the hash
+NOISE_INLINE float gradientDot(std::uint32_t hash, float x, float y, float z)
+{
+    std::uint32_t h = hash & 15u;
+    float a = h < 8u ? x : y;
+    float b = h < 4u ? y : (h == 12u || h == 14u ? x : z);
+    return ((h & 1u) ? -a : a) + ((h & 2u) ? -b : b);
+}
+
+// Contribution of one simplex corner at offset (x, y, z) from the sample
+NOISE_INLINE float simplexCorner(std::uint32_t hash, float x, float y, float z)
+{
+    float t = 0.6f - x * x - y * y - z * z;
+    t = t > 0.0f ? t : 0.0f;
+    t *= t;
+    return t * t * gradientDot(hash, x, y, z);
+}
+
+// 3D simplex noise (Perlin 2002, as laid out in Gustavson's "Simplex noise
+// demystified"), in roughly [-1, 1]
+NOISE_INLINE float simplexNoise(float x, float y, float z, std::uint32_t seed)
+{
+    const float skew = 1.0f / 3.0f;
+    const float unskew = 1.0f / 6.0f;
+
+    // Cell of the skewed lattice, and the sample's offset from its origin corner
+    float s = (x + y + z) * skew;
+    std::int32_t i = floorToInt(x + s), j = floorToInt(y + s), k = floorToInt(z + s);
+    float t = (float)(i + j + k) * unskew;
+    float x0 = x - ((float)i - t), y0 = y - ((float)j - t), z0 = z - ((float)k - t);
+
+    // The cell's six tetrahedra are picked by ranking the offsets, without branches
+    std::int32_t xy = x0 >= y0, xz = x0 >= z0, yz = y0 >= z0;
+    std::int32_t rankX = xy + xz, rankY = (1 - xy) + yz, rankZ = (1 - xz) + (1 - yz);
+    std::int32_t i1 = rankX >= 2, j1 = rankY >= 2, k1 = rankZ >= 2;
+    std::int32_t i2 = rankX >= 1, j2 = rankY >= 1, k2 = rankZ >= 1;
+
+    float sum = simplexCorner(latticeHash(i, j, k, seed), x0, y0, z0);
+    sum += simplexCorner(latticeHash(i + i1, j + j1, k + k1, seed), x0 - (float)i1 + unskew, y0 - (float)j1 + unskew,
+                         z0 - (float)k1 + unskew);
+    sum += simplexCorner(latticeHash(i + i2, j + j2, k + k2, seed), x0 - (float)i2 + 2.0f * unskew,
+                         y0 - (float)j2 + 2.0f * unskew, z0 - (float)k2 + 2.0f * unskew);
+    sum += simplexCorner(latticeHash(i + 1, j + 1, k + 1, seed), x0 - 1.0f + 3.0f * unskew, y0 - 1.0f + 3.0f * unskew,
+                         z0 - 1.0f + 3.0f * unskew);
+    return 32.0f * sum;
+}
+
+// Fractional Brownian motion: octaves of simplex noise, each at twice the
+// frequency and half the amplitude of the last, normalized to roughly [-1, 1]
+template <int Octaves>
+NOISE_INLINE float fbm(float x, float y, float z, std::uint32_t seed)
+{
+    float sum = 0.0f, amplitude = 1.0f, frequency = 1.0f, total = 0.0f;
+    NOISE_UNROLL
+    for (int octave = 0; octave < Octaves; octave++)
+    {
+        sum += amplitude * simplexNoise(x * frequency, y * frequency, z * frequency, seed + (std::uint32_t)octave);
+        total += amplitude;
+        amplitude *= 0.5f;
+        frequency *= 2.0f;
+    }
+    return sum / total;
+}
+
+// Ridged multifractal (Musgrave): sharp crests where the noise crosses zero,
+// each octave weighted by the one before so detail gathers on the ridges. In [0, 1].
+template <int Octaves>
+NOISE_INLINE float ridged(float x, float y, float z, std::uint32_t seed)
+{
+    float sum = 0.0f, amplitude = 1.0f, frequency = 1.0f, total = 0.0f, weight = 1.0f;
+    NOISE_UNROLL
+    for (int octave = 0; octave < Octaves; octave++)
+    {
+        float n = simplexNoise(x * frequency, y * frequency, z * frequency, seed + (std::uint32_t)octave);
+        float ridge = 1.0f - (n < 0.0f ? -n : n);
+        ridge *= ridge * weight;
+        weight = ridge > 1.0f ? 1.0f : ridge;
+        sum += amplitude * ridge;
+        total += amplitude;
+        amplitude *= 0.5f;
+        frequency *= 2.0f;
+    }
+    return sum / total;
+}
+
+// fBm sampled at a point displaced by three other fBm fields (Quilez's domain
+// warping), which turns round blobs into swirls and coastlines
+template <int Octaves, int WarpOctaves>
+NOISE_INLINE float warpedFbm(float x, float y, float z, float strength, std::uint32_t seed)
+{
+    float wx = fbm<WarpOctaves>(x + 1.7f, y + 9.2f, z + 3.4f, seed + 101u);
+    float wy = fbm<WarpOctaves>(x + 8.3f, y + 2.8f, z + 5.1f, seed + 211u);
+    float wz = fbm<WarpOctaves>(x + 4.6f, y + 7.1f, z + 1.9f, seed + 307u);
+    return fbm<Octaves>(x + strength * wx, y + strength * wy, z + strength * wz, seed);
+}
+
+NOISE_INLINE float smoothStep(float edge0, float edge1, float x)
+{
+    float t = (x - edge0) / (edge1 - edge0);
+    t = t < 0.0f ? 0.0f : t > 1.0f ? 1.0f : t;
+    return t * t * (3.0f - 2.0f * t);
+}
+
+NOISE_INLINE float mix(float a, float b, float t)
+{
+    return a + (b - a) * t;
+}
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <cstddef>
+
+// Pairwise gravity kernels for DirectSolver, one set per instruction set. Each
+// set lives in its own source file compiled for that instruction set, so these
+// files must stay free of standard library templates: an inline function
+// compiled with AVX-512 there could be picked by the linker for every caller.
+
+// Structure-of-arrays positions and masses
+template <typename T>
+struct DirectSources
+{
+    const T *x, *y, *z, *mass;
+    std::size_t count;
+};
+
+// Targets and the sums they accumulate into. count must be a multiple of the
+// kernel's blockSize; the kernel adds to acceleration and potential (no G).
+template <typename T>
+struct DirectTargets
+{
+    const T *x, *y, *z;
+    T *ax, *ay, *az, *potential;
+    std::size_t count;
+};
+
+struct DirectKernels
+{
+    const char *name;
+
+    // Targets handled together: two vectors of the narrowest (float) type
+    std::size_t blockSize;
+
+    void (*accumulateFloat)(const DirectSources<float> &sources, const DirectTargets<float> &targets, float eps2);
+    void (*accumulateDouble)(const DirectSources<double> &sources, const DirectTargets<double> &targets, double eps2);
+};
+
+// Kernel sets; each returns null when its file was built without the instruction set
+const DirectKernels *scalarDirectKernels();
+const DirectKernels *sse42DirectKernels();
+const DirectKernels *avx2DirectKernels();
+const DirectKernels *avx512DirectKernels();
+
+// The register-blocked loop shared by every kernel set. V supplies a vector
+// type and its operations for one precision; each target block keeps two
+// vectors of targets in registers while every source is broadcast against them.
+template <typename V>
+void accumulateDirect(const DirectSources<typename V::Scalar> &sources,
+                      const DirectTargets<typename V::Scalar> &targets,
+                      typename V::Scalar eps2)
+{
+    typedef typename V::Vector Vector;
+    const std::size_t width = V::width;
+    const Vector softening2 = V::broadcast(eps2);
+
+    for (std::size_t i = 0; i < targets.count; i += 2 * width)
+    {
+        Vector x0 = V::load(targets.x + i), x1 = V::load(targets.x + i + width);
+        Vector y0 = V::load(targets.y + i), y1 = V::load(targets.y + i + width);
+        Vector z0 = V::load(targets.z + i), z1 = V::load(targets.z + i + width);
+
+        Vector ax0 = V::zero(), ax1 = V::zero();
+        Vector ay0 = V::zero(), ay1 = V::zero();
+        Vector az0 = V::zero(), az1 = V::zero();
+        Vector phi0 = V::zero(), phi1 = V::zero();
+
+        for (std::size_t j = 0; j < sources.count; j++)
+        {
+            Vector sx = V::broadcast(sources.x[j]);
+            Vector sy = V::broadcast(sources.y[j]);
+            Vector sz = V::broadcast(sources.z[j]);
+            Vector m = V::broadcast(sources.mass[j]);
+
+            Vector dx0 = V::sub(sx, x0), dx1 = V::sub(sx, x1);
+            Vector dy0 = V::sub(sy, y0), dy1 = V::sub(sy, y1);
+            Vector dz0 = V::sub(sz, z0), dz1 = V::sub(sz, z1);
+
+            Vector r20 = V::fma(dx0, dx0, V::fma(dy0, dy0, V::fma(dz0, dz0, softening2)));
+            Vector r21 = V::fma(dx1, dx1, V::fma(dy1, dy1, V::fma(dz1, dz1, softening2)));
+
+            Vector inv0 = V::rsqrt(r20), inv1 = V::rsqrt(r21);
+            Vector mInv0 = V::mul(m, inv0), mInv1 = V::mul(m, inv1);
+            Vector mInv30 = V::mul(mInv0, V::mul(inv0, inv0));
+            Vector mInv31 = V::mul(mInv1, V::mul(inv1, inv1));
+
+            ax0 = V::fma(dx0, mInv30, ax0);
+            ax1 = V::fma(dx1, mInv31, ax1);
+            ay0 = V::fma(dy0, mInv30, ay0);
+            ay1 = V::fma(dy1, mInv31, ay1);
+            az0 = V::fma(dz0, mInv30, az0);
+            az1 = V::fma(dz1, mInv31, az1);
+            phi0 = V::sub(phi0, mInv0);
+            phi1 = V::sub(phi1, mInv1);
+        }
+
+        V::store(targets.ax + i, V::add(V::load(targets.ax + i), ax0));
+        V::store(targets.ax + i + width, V::add(V::load(targets.ax + i + width), ax1));
+        V::store(targets.ay + i, V::add(V::load(targets.ay + i), ay0));
+        V::store(targets.ay + i + width, V::add(V::load(targets.ay + i + width), ay1));
+        V::store(targets.az + i, V::add(V::load(targets.az + i), az0));
+        V::store(targets.az + i + width, V::add(V::load(targets.az + i + width), az1));
+        V::store(targets.potential + i, V::add(V::load(targets.potential + i), phi0));
+        V::store(targets.potential + i + width, V::add(V::load(targets.potential + i + width), phi1));
+    }
+}
@@ -0,0 +1,74 @@
+// Compiled with AVX2 and FMA enabled (see CMakeLists.txt)
+#include "direct_kernels.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+
+namespace
+{
+struct FloatAvx2
+{
+    typedef float Scalar;
+    typedef __m256 Vector;
+    static const std::size_t width = 8;
+
+    static Vector zero() { return _mm256_setzero_ps(); }
+    static Vector broadcast(float v) { return _mm256_set1_ps(v); }
+    static Vector load(const float *p) { return _mm256_loadu_ps(p); }
+    static void store(float *p, Vector v) { _mm256_storeu_ps(p, v); }
+    static Vector add(Vector a, Vector b) { return _mm256_add_ps(a, b); }
+    static Vector sub(Vector a, Vector b) { return _mm256_sub_ps(a, b); }
+    static Vector mul(Vector a, Vector b) { return _mm256_mul_ps(a, b); }
+    static Vector fma(Vector a, Vector b, Vector c) { return _mm256_fmadd_ps(a, b, c); }
+
+    // 12-bit estimate refined by one Newton step to about 23 bits
+    static Vector rsqrt(Vector x)
+    {
+        Vector y = _mm256_rsqrt_ps(x);
+        Vector yyx = _mm256_mul_ps(_mm256_mul_ps(y, y), x);
+        return _mm256_mul_ps(_mm256_mul_ps(_mm256_set1_ps(0.5f), y), _mm256_sub_ps(_mm256_set1_ps(3.0f), yyx));
+    }
+};
+
+struct DoubleAvx2
+{
+    typedef double Scalar;
+    typedef __m256d Vector;
+    static const std::size_t width = 4;
+
+    static Vector zero() { return _mm256_setzero_pd(); }
+    static Vector broadcast(double v) { return _mm256_set1_pd(v); }
+    static Vector load(const double *p) { return _mm256_loadu_pd(p); }
+    static void store(double *p, Vector v) { _mm256_storeu_pd(p, v); }
+    static Vector add(Vector a, Vector b) { return _mm256_add_pd(a, b); }
+    static Vector sub(Vector a, Vector b) { return _mm256_sub_pd(a, b); }
+    static Vector mul(Vector a, Vector b) { return _mm256_mul_pd(a, b); }
+    static Vector fma(Vector a, Vector b, Vector c) { return _mm256_fmadd_pd(a, b, c); }
+
+    // IEEE square root and divide: double results are reference quality
+    static Vector rsqrt(Vector x) { return _mm256_div_pd(_mm256_set1_pd(1.0), _mm256_sqrt_pd(x)); }
+};
+
+void accumulateFloat(const DirectSources<float> &sources, const DirectTargets<float> &targets, float eps2)
+{
+    accumulateDirect<FloatAvx2>(sources, targets, eps2);
+}
+
+void accumulateDouble(const DirectSources<double> &sources, const DirectTargets<double> &targets, double eps2)
+{
+    accumulateDirect<DoubleAvx2>(sources, targets, eps2);
+}
+
+const DirectKernels kernels = {"AVX2", 2 * FloatAvx2::width, accumulateFloat, accumulateDouble};
+}
+
+const DirectKernels *avx2DirectKernels()
+{
+    return &kernels;
+}
+#else
+const DirectKernels *avx2DirectKernels()
+{
+    return nullptr;
+}
+#endif
@@ -0,0 +1,74 @@
+// Compiled with AVX-512F enabled (see CMakeLists.txt)
+#include "direct_kernels.h"
+
+#if defined(__AVX512F__)
+#include <immintrin.h>
+
+namespace
+{
+struct FloatAvx512
+{
+    typedef float Scalar;
+    typedef __m512 Vector;
+    static const std::size_t width = 16;
+
+    static Vector zero() { return _mm512_setzero_ps(); }
+    static Vector broadcast(float v) { return _mm512_set1_ps(v); }
+    static Vector load(const float *p) { return _mm512_loadu_ps(p); }
+    static void store(float *p, Vector v) { _mm512_storeu_ps(p, v); }
+    static Vector add(Vector a, Vector b) { return _mm512_add_ps(a, b); }
+    static Vector sub(Vector a, Vector b) { return _mm512_sub_ps(a, b); }
+    static Vector mul(Vector a, Vector b) { return _mm512_mul_ps(a, b); }
+    static Vector fma(Vector a, Vector b, Vector c) { return _mm512_fmadd_ps(a, b, c); }
+
+    // 14-bit estimate refined by one Newton step to full float precision
+    static Vector rsqrt(Vector x)
+    {
+        Vector y = _mm512_rsqrt14_ps(x);
+        Vector yyx = _mm512_mul_ps(_mm512_mul_ps(y, y), x);
+        return _mm512_mul_ps(_mm512_mul_ps(_mm512_set1_ps(0.5f), y), _mm512_sub_ps(_mm512_set1_ps(3.0f), yyx));
+    }
+};
+
+struct DoubleAvx512
+{
+    typedef double Scalar;
+    typedef __m512d Vector;
+    static const std::size_t width = 8;
+
+    static Vector zero() { return _mm512_setzero_pd(); }
+    static Vector broadcast(double v) { return _mm512_set1_pd(v); }
+    static Vector load(const double *p) { return _mm512_loadu_pd(p); }
+    static void store(double *p, Vector v) { _mm512_storeu_pd(p, v); }
+    static Vector add(Vector a, Vector b) { return _mm512_add_pd(a, b); }
+    static Vector sub(Vector a, Vector b) { return _mm512_sub_pd(a, b); }
+    static Vector mul(Vector a, Vector b) { return _mm512_mul_pd(a, b); }
+    static Vector fma(Vector a, Vector b, Vector c) { return _mm512_fmadd_pd(a, b, c); }
+
+    // IEEE square root and divide: double results are reference quality
+    static Vector rsqrt(Vector x) { return _mm512_div_pd(_mm512_set1_pd(1.0), _mm512_sqrt_pd(x)); }
+};
+
+void accumulateFloat(const DirectSources<float> &sources, const DirectTargets<float> &targets, float eps2)
+{
+    accumulateDirect<FloatAvx512>(sources, targets, eps2);
+}
+
+void accumulateDouble(const DirectSources<double> &sources, const DirectTargets<double> &targets, double eps2)
+{
+    accumulateDirect<DoubleAvx512>(sources, targets, eps2);
+}
+
+const DirectKernels kernels = {"AVX-512", 2 * FloatAvx512::width, accumulateFloat, accumulateDouble};
+}
+
+const DirectKernels *avx512DirectKernels()
+{
+    return &kernels;
+}
+#else
+const DirectKernels *avx512DirectKernels()
+{
+    return nullptr;
+}
+#endif
@@ -0,0 +1,42 @@
+// Portable fallback, built with the project's default flags
+#include "direct_kernels.h"
+
+#include <cmath>
+
+namespace
+{
+template <typename T>
+struct ScalarOps
+{
+    typedef T Scalar;
+    typedef T Vector;
+    static const std::size_t width = 1;
+
+    static Vector zero() { return T(0); }
+    static Vector broadcast(T v) { return v; }
+    static Vector load(const T *p) { return *p; }
+    static void store(T *p, Vector v) { *p = v; }
+    static Vector add(Vector a, Vector b) { return a + b; }
+    static Vector sub(Vector a, Vector b) { return a - b; }
+    static Vector mul(Vector a, Vector b) { return a * b; }
+    static Vector fma(Vector a, Vector b, Vector c) { return a * b + c; }
+    static Vector rsqrt(Vector x) { return T(1) / std::sqrt(x); }
+};
+
+void accumulateFloat(const DirectSources<float> &sources, const DirectTargets<float> &targets, float eps2)
+{
+    accumulateDirect<ScalarOps<float>>(sources, targets, eps2);
+}
+
+void accumulateDouble(const DirectSources<double> &sources, const DirectTargets<double> &targets, double eps2)
+{
+    accumulateDirect<ScalarOps<double>>(sources, targets, eps2);
+}
+
+const DirectKernels kernels = {"Scalar", 2, accumulateFloat, accumulateDouble};
+}
+
+const DirectKernels *scalarDirectKernels()
+{
+    return &kernels;
+}
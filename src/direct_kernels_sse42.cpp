@@ -0,0 +1,75 @@
+// Compiled with SSE4.2 enabled (see CMakeLists.txt)
+#include "direct_kernels.h"
+
+#if defined(__SSE4_2__) || (defined(_MSC_VER) && defined(_M_X64))
+#include <immintrin.h>
+
+namespace
+{
+// SSE has no fused multiply-add, so fma is a multiply and an add
+struct FloatSse
+{
+    typedef float Scalar;
+    typedef __m128 Vector;
+    static const std::size_t width = 4;
+
+    static Vector zero() { return _mm_setzero_ps(); }
+    static Vector broadcast(float v) { return _mm_set1_ps(v); }
+    static Vector load(const float *p) { return _mm_loadu_ps(p); }
+    static void store(float *p, Vector v) { _mm_storeu_ps(p, v); }
+    static Vector add(Vector a, Vector b) { return _mm_add_ps(a, b); }
+    static Vector sub(Vector a, Vector b) { return _mm_sub_ps(a, b); }
+    static Vector mul(Vector a, Vector b) { return _mm_mul_ps(a, b); }
+    static Vector fma(Vector a, Vector b, Vector c) { return _mm_add_ps(_mm_mul_ps(a, b), c); }
+
+    // 12-bit estimate refined by one Newton step to about 23 bits
+    static Vector rsqrt(Vector x)
+    {
+        Vector y = _mm_rsqrt_ps(x);
+        Vector yyx = _mm_mul_ps(_mm_mul_ps(y, y), x);
+        return _mm_mul_ps(_mm_mul_ps(_mm_set1_ps(0.5f), y), _mm_sub_ps(_mm_set1_ps(3.0f), yyx));
+    }
+};
+
+struct DoubleSse
+{
+    typedef double Scalar;
+    typedef __m128d Vector;
+    static const std::size_t width = 2;
+
+    static Vector zero() { return _mm_setzero_pd(); }
+    static Vector broadcast(double v) { return _mm_set1_pd(v); }
+    static Vector load(const double *p) { return _mm_loadu_pd(p); }
+    static void store(double *p, Vector v) { _mm_storeu_pd(p, v); }
+    static Vector add(Vector a, Vector b) { return _mm_add_pd(a, b); }
+    static Vector sub(Vector a, Vector b) { return _mm_sub_pd(a, b); }
+    static Vector mul(Vector a, Vector b) { return _mm_mul_pd(a, b); }
+    static Vector fma(Vector a, Vector b, Vector c) { return _mm_add_pd(_mm_mul_pd(a, b), c); }
+
+    // IEEE square root and divide: double results are reference quality
+    static Vector rsqrt(Vector x) { return _mm_div_pd(_mm_set1_pd(1.0), _mm_sqrt_pd(x)); }
+};
+
+void accumulateFloat(const DirectSources<float> &sources, const DirectTargets<float> &targets, float eps2)
+{
+    accumulateDirect<FloatSse>(sources, targets, eps2);
+}
+
+void accumulateDouble(const DirectSources<double> &sources, const DirectTargets<double> &targets, double eps2)
+{
+    accumulateDirect<DoubleSse>(sources, targets, eps2);
+}
+
+const DirectKernels kernels = {"SSE4.2", 2 * FloatSse::width, accumulateFloat, accumulateDouble};
+}
+
+const DirectKernels *sse42DirectKernels()
+{
+    return &kernels;
+}
+#else
+const DirectKernels *sse42DirectKernels()
+{
+    return nullptr;
+}
+#endif
@@ -0,0 +1,163 @@
+#include "direct_solver.h"
+#include "direct_kernels.h"
+
+#include <algorithm>
+#include <chrono>
+
+namespace
+{
+// Sources per tile: 2048 floats per coordinate is 32 KB of positions and
+// masses, which stays in L1 while a range of targets sweeps over it
+const std::size_t sourceTileSize = 2048;
+
+// Targets per kernel call; each parallel chunk covers at least this many
+const std::size_t targetGroupSize = 256;
+
+double secondsSince(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+const DirectKernels *kernelsFor(SimdLevel level)
+{
+    switch (level)
+    {
+    case SimdLevel::AVX512:
+        return avx512DirectKernels();
+    case SimdLevel::AVX2:
+        return avx2DirectKernels();
+    case SimdLevel::SSE42:
+        return sse42DirectKernels();
+    case SimdLevel::Scalar:
+        break;
+    }
+    return scalarDirectKernels();
+}
+
+bool available(SimdLevel level)
+{
+    return kernelsFor(level) != nullptr && cpuSupports(level);
+}
+
+void accumulate(const DirectKernels &kernels, const DirectSources<float> &sources, const DirectTargets<float> &targets, float eps2)
+{
+    kernels.accumulateFloat(sources, targets, eps2);
+}
+
+void accumulate(const DirectKernels &kernels, const DirectSources<double> &sources, const DirectTargets<double> &targets, double eps2)
+{
+    kernels.accumulateDouble(sources, targets, eps2);
+}
+}
+
+SimdLevel detectSimdLevel()
+{
+    const SimdLevel levels[] = {SimdLevel::AVX512, SimdLevel::AVX2, SimdLevel::SSE42};
+    for (SimdLevel level : levels)
+    {
+        if (available(level))
+        {
+            return level;
+        }
+    }
+    return SimdLevel::Scalar;
+}
+
+DirectSolver::DirectSolver(ThreadPool &pool) : simdLevel(detectSimdLevel()), pool(pool)
+{
+}
+
+SimdLevel DirectSolver::activeLevel() const
+{
+    SimdLevel level = simdLevel;
+    while (level != SimdLevel::Scalar && !available(level))
+    {
+        level = (SimdLevel)((int)level - 1);
+    }
+    return level;
+}
+
+void DirectSolver::computeForces(ParticleSystem &particles)
+{
+    const DirectKernels &kernels = *kernelsFor(activeLevel());
+    if (singlePrecision)
+    {
+        evaluate(particles, floatBuffer, kernels);
+    }
+    else
+    {
+        evaluate(particles, doubleBuffer, kernels);
+    }
+}
+
+template <typename T>
+void DirectSolver::evaluate(ParticleSystem &particles, AlignedVector<T> &buffer, const DirectKernels &kernels)
+{
+    auto start = std::chrono::steady_clock::now();
+    const std::size_t n = particles.size();
+
+    // Pad to whole target blocks with massless particles; they add nothing as
+    // sources and their own results are discarded
+    const std::size_t padded = (n + kernels.blockSize - 1) / kernels.blockSize * kernels.blockSize;
+    buffer.assign(padded * 8, T(0));
+    T *x = buffer.data(), *y = x + padded, *z = y + padded, *mass = z + padded;
+    T *ax = mass + padded, *ay = ax + padded, *az = ay + padded, *potential = az + padded;
+
+    // Positions relative to the centroid keep float differences accurate away from the origin
+    glm::dvec3 centre(0.0);
+    for (std::size_t i = 0; i < n; i++)
+    {
+        centre += glm::dvec3(particles.x[i], particles.y[i], particles.z[i]);
+    }
+    if (n > 0)
+    {
+        centre /= (double)n;
+    }
+    for (std::size_t i = 0; i < n; i++)
+    {
+        x[i] = (T)(particles.x[i] - centre.x);
+        y[i] = (T)(particles.y[i] - centre.y);
+        z[i] = (T)(particles.z[i] - centre.z);
+        mass[i] = (T)particles.mass[i];
+    }
+
+    lastTimings.buildSeconds = secondsSince(start);
+    start = std::chrono::steady_clock::now();
+
+    const double selfSoftening = softeningLength();
+    const T eps2 = (T)(selfSoftening * selfSoftening);
+    const std::size_t blockCount = padded / kernels.blockSize;
+    const std::size_t blocksPerGroup = targetGroupSize / kernels.blockSize;
+
+    pool.parallelFor(blockCount, blocksPerGroup, [&](std::size_t beginBlock, std::size_t endBlock)
+                     {
+        const std::size_t begin = beginBlock * kernels.blockSize;
+        const std::size_t end = endBlock * kernels.blockSize;
+
+        // Each source tile is swept over every target group in this range before moving on
+        for (std::size_t tile = 0; tile < n; tile += sourceTileSize)
+        {
+            DirectSources<T> sources = {x + tile, y + tile, z + tile, mass + tile, std::min(sourceTileSize, n - tile)};
+
+            for (std::size_t group = begin; group < end; group += targetGroupSize)
+            {
+                std::size_t count = std::min(targetGroupSize, end - group);
+                DirectTargets<T> targets = {x + group, y + group, z + group,
+                                            ax + group, ay + group, az + group, potential + group, count};
+                accumulate(kernels, sources, targets, eps2);
+            }
+        } });
+
+    // Each particle's own term added -m / softening to its potential
+    const double G = gravitationalConstant;
+    for (std::size_t i = 0; i < n; i++)
+    {
+        particles.ax[i] = G * ax[i];
+        particles.ay[i] = G * ay[i];
+        particles.az[i] = G * az[i];
+        particles.potential[i] = G * (potential[i] + particles.mass[i] / selfSoftening);
+    }
+
+    lastInteractions = (double)padded * (double)n;
+    lastTimings.forceSeconds = secondsSince(start);
+}
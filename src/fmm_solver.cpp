@@ -0,0 +1,563 @@
+#include "fmm_solver.h"
+#include "morton_order.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+namespace
+{
+// Subtrees with more particles than this are split across the pool
+const int parallelThreshold = 8192;
+
+// Upper limit for expansionOrder; sizes the scratch arrays below
+const int maxExpansionOrder = 16;
+const int maxTerms = (maxExpansionOrder + 1) * (maxExpansionOrder + 2) / 2;
+const int maxFullTerms = (maxExpansionOrder + 1) * (maxExpansionOrder + 1);
+
+typedef std::complex<double> Complex;
+
+double secondsSince(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+inline int termIndex(int n, int m)
+{
+    return n * (n + 1) / 2 + m;
+}
+
+// Index of (n, m) among all -n <= m <= n
+inline int fullIndex(int n, int m)
+{
+    return n * n + n + m;
+}
+
+// Expand stored coefficients (m >= 0) to every -n <= m <= n using
+// X_n^-m = (-1)^m conj(X_n^m), optionally conjugated and multiplied by (-1)^n.
+// Real and imaginary parts are split so the translation sums are plain
+// multiply-adds (and std::complex's checks for infinities are avoided).
+void unpack(int order, const Complex *X, double *re, double *im, bool conjugate, bool alternateDegree)
+{
+    for (int n = 0; n <= order; n++)
+    {
+        double degreeSign = alternateDegree && (n & 1) ? -1.0 : 1.0;
+        double imagSign = conjugate ? -1.0 : 1.0;
+        for (int m = 0; m <= n; m++)
+        {
+            const Complex &value = X[termIndex(n, m)];
+            re[fullIndex(n, m)] = degreeSign * value.real();
+            im[fullIndex(n, m)] = degreeSign * imagSign * value.imag();
+            if (m > 0)
+            {
+                double orderSign = (m & 1) ? -degreeSign : degreeSign;
+                re[fullIndex(n, -m)] = orderSign * value.real();
+                im[fullIndex(n, -m)] = -orderSign * imagSign * value.imag();
+            }
+        }
+    }
+}
+
+// Softened direct sums of sources [sourceBegin, sourceEnd) onto targets
+// [targetBegin, targetEnd). Sources outside, targets inside: the inner loop has
+// no reductions, so it vectorizes.
+void accumulatePairs(const double *__restrict x, const double *__restrict y, const double *__restrict z,
+                     const double *__restrict mass, double *__restrict ax, double *__restrict ay,
+                     double *__restrict az, double *__restrict phi, int targetBegin, int targetEnd,
+                     int sourceBegin, int sourceEnd, double eps2)
+{
+    for (int j = sourceBegin; j < sourceEnd; j++)
+    {
+        const double xj = x[j], yj = y[j], zj = z[j], mj = mass[j];
+        for (int i = targetBegin; i < targetEnd; i++)
+        {
+            double dx = xj - x[i];
+            double dy = yj - y[i];
+            double dz = zj - z[i];
+            double inv = 1.0 / std::sqrt(dx * dx + dy * dy + dz * dz + eps2);
+            double mInv = mj * inv;
+            double mInv3 = mInv * inv * inv;
+            ax[i] += dx * mInv3;
+            ay[i] += dy * mInv3;
+            az[i] += dz * mInv3;
+            phi[i] -= mInv;
+        }
+    }
+}
+
+// Regular solid harmonics R_n^m(x, y, z) for 0 <= m <= n <= order, normalised so that
+// R_n^m(a + b) = sum R_k^l(a) R_(n-k)^(m-l)(b)
+void regularHarmonics(int order, double x, double y, double z, Complex *R)
+{
+    const double r2 = x * x + y * y + z * z;
+    const Complex xy(x, y);
+    R[0] = 1.0;
+    for (int n = 1; n <= order; n++)
+    {
+        R[termIndex(n, n)] = -xy / (2.0 * n) * R[termIndex(n - 1, n - 1)];
+        for (int m = n - 1; m >= 0; m--)
+        {
+            Complex previous = m <= n - 2 ? R[termIndex(n - 2, m)] : Complex(0.0);
+            R[termIndex(n, m)] = ((2.0 * n - 1.0) * z * R[termIndex(n - 1, m)] - r2 * previous) / (double)((n + m) * (n - m));
+        }
+    }
+}
+
+// Irregular solid harmonics I_n^m(x, y, z), normalised so that
+// 1 / |a - b| = sum conj(R_n^m(b)) I_n^m(a) for |b| < |a|
+void irregularHarmonics(int order, double x, double y, double z, Complex *I)
+{
+    const double r2 = x * x + y * y + z * z;
+    const double inverseR2 = 1.0 / r2;
+    const Complex xy(x, y);
+    I[0] = std::sqrt(inverseR2);
+    for (int n = 1; n <= order; n++)
+    {
+        I[termIndex(n, n)] = -(2.0 * n - 1.0) * xy * inverseR2 * I[termIndex(n - 1, n - 1)];
+        for (int m = n - 1; m >= 0; m--)
+        {
+            Complex previous = m <= n - 2 ? I[termIndex(n - 2, m)] : Complex(0.0);
+            I[termIndex(n, m)] = ((2.0 * n - 1.0) * z * I[termIndex(n - 1, m)] - (double)((n - 1) * (n - 1) - m * m) * previous) * inverseR2;
+        }
+    }
+}
+}
+
+FmmSolver::FmmSolver(ThreadPool &pool) : pool(pool)
+{
+}
+
+void FmmSolver::computeForces(ParticleSystem &particles)
+{
+    auto start = std::chrono::steady_clock::now();
+    const std::size_t n = particles.size();
+    cells.clear();
+    if (n == 0)
+    {
+        lastTimings = Timings();
+        return;
+    }
+
+    degree = std::min(std::max(expansionOrder, 0), maxExpansionOrder);
+    termCount = (degree + 1) * (degree + 2) / 2;
+
+    glm::dvec3 low;
+    double extent = boundingCube(pool, particles, low);
+    mortonSort(pool, particles, low, extent, codes, order);
+
+    sortedX.resize(n);
+    sortedY.resize(n);
+    sortedZ.resize(n);
+    sortedMass.resize(n);
+    pool.parallelFor(n, 16384, [&](std::size_t begin, std::size_t end)
+                     {
+        for (std::size_t k = begin; k < end; k++)
+        {
+            int i = order[k];
+            sortedX[k] = particles.x[i];
+            sortedY[k] = particles.y[i];
+            sortedZ[k] = particles.z[i];
+            sortedMass[k] = particles.mass[i];
+        } });
+
+    cells.push_back(Cell{0.0, 0.0, 0.0, 0.0, 0.0, 0, (int)n, 0, 0});
+    buildCells(0, 0);
+
+    multipoles.assign(cells.size() * termCount, Complex(0.0));
+    upward(0);
+    lastTimings.buildSeconds = secondsSince(start);
+
+    start = std::chrono::steady_clock::now();
+    locals.assign(cells.size() * termCount, Complex(0.0));
+    accX.assign(n, 0.0);
+    accY.assign(n, 0.0);
+    accZ.assign(n, 0.0);
+    potential.assign(n, 0.0);
+
+    Counts counts;
+    interact(0, 0, counts);
+    lastMultipoleToLocal = counts.multipoleToLocal;
+    lastParticlePairs = counts.particlePairs;
+
+    downward(0);
+
+    // Each particle's own near-field term added -m / softening to its potential
+    const double G = gravitationalConstant;
+    const double selfSoftening = softeningLength();
+    pool.parallelFor(n, 16384, [&](std::size_t begin, std::size_t end)
+                     {
+        for (std::size_t k = begin; k < end; k++)
+        {
+            int i = order[k];
+            particles.ax[i] = G * accX[k];
+            particles.ay[i] = G * accY[k];
+            particles.az[i] = G * accZ[k];
+            particles.potential[i] = G * (potential[k] + sortedMass[k] / selfSoftening);
+        } });
+    lastTimings.forceSeconds = secondsSince(start);
+}
+
+void FmmSolver::buildCells(int index, int level)
+{
+    int begin = cells[index].begin, end = cells[index].end;
+    if (end - begin <= leafSize || level >= mortonBits)
+    {
+        return;
+    }
+
+    int bounds[9];
+    int children = splitOctants(codes, begin, end, level, bounds);
+    int first = (int)cells.size();
+    cells[index].firstChild = first;
+    cells[index].childCount = children;
+    for (int c = 0; c < children; c++)
+    {
+        cells.push_back(Cell{0.0, 0.0, 0.0, 0.0, 0.0, bounds[c], bounds[c + 1], 0, 0});
+    }
+    for (int c = 0; c < children; c++)
+    {
+        buildCells(first + c, level + 1);
+    }
+}
+
+void FmmSolver::upward(int index)
+{
+    Cell &cell = cells[index];
+    if (cell.childCount == 0)
+    {
+        particleToMultipole(index);
+        return;
+    }
+
+    if (cell.end - cell.begin > parallelThreshold)
+    {
+        pool.parallelFor(cell.childCount, 1, [&](std::size_t first, std::size_t last)
+                         {
+            for (std::size_t c = first; c < last; c++)
+            {
+                upward(cell.firstChild + (int)c);
+            } });
+    }
+    else
+    {
+        for (int c = 0; c < cell.childCount; c++)
+        {
+            upward(cell.firstChild + c);
+        }
+    }
+
+    // Centre of mass of the children (their mean for massless cells); the radius
+    // bounds every child's sphere
+    double mass = 0.0;
+    for (int c = cell.firstChild; c < cell.firstChild + cell.childCount; c++)
+    {
+        mass += cells[c].mass;
+    }
+    double x = 0.0, y = 0.0, z = 0.0;
+    for (int c = cell.firstChild; c < cell.firstChild + cell.childCount; c++)
+    {
+        const Cell &child = cells[c];
+        double weight = mass > 0.0 ? child.mass / mass : 1.0 / cell.childCount;
+        x += weight * child.x;
+        y += weight * child.y;
+        z += weight * child.z;
+    }
+    cell.mass = mass;
+    cell.x = x;
+    cell.y = y;
+    cell.z = z;
+
+    double radius = 0.0;
+    for (int c = cell.firstChild; c < cell.firstChild + cell.childCount; c++)
+    {
+        const Cell &child = cells[c];
+        double dx = child.x - cell.x, dy = child.y - cell.y, dz = child.z - cell.z;
+        radius = std::max(radius, std::sqrt(dx * dx + dy * dy + dz * dz) + child.radius);
+        multipoleToMultipole(c, index);
+    }
+    cell.radius = radius;
+}
+
+void FmmSolver::interact(int a, int b, Counts &counts)
+{
+    const Cell &A = cells[a];
+    const Cell &B = cells[b];
+
+    double dx = B.x - A.x, dy = B.y - A.y, dz = B.z - A.z;
+    double reach = A.radius + B.radius;
+    if (reach * reach < openingAngle * openingAngle * (dx * dx + dy * dy + dz * dz))
+    {
+        multipoleToLocal(b, a);
+        counts.multipoleToLocal++;
+        return;
+    }
+
+    bool leafA = A.childCount == 0, leafB = B.childCount == 0;
+    if (leafA && leafB)
+    {
+        particlesToParticles(a, b);
+        counts.particlePairs += (std::size_t)(A.end - A.begin) * (std::size_t)(B.end - B.begin);
+        return;
+    }
+
+    // Split the larger cell. Only splitting the target side may run in
+    // parallel: each child then writes to its own subtree alone.
+    if (leafB || (!leafA && A.radius >= B.radius))
+    {
+        if (A.end - A.begin > parallelThreshold)
+        {
+            std::vector<Counts> childCounts(A.childCount);
+            pool.parallelFor(A.childCount, 1, [&](std::size_t first, std::size_t last)
+                             {
+                for (std::size_t c = first; c < last; c++)
+                {
+                    interact(A.firstChild + (int)c, b, childCounts[c]);
+                } });
+            for (const Counts &child : childCounts)
+            {
+                counts.multipoleToLocal += child.multipoleToLocal;
+                counts.particlePairs += child.particlePairs;
+            }
+        }
+        else
+        {
+            for (int c = A.firstChild; c < A.firstChild + A.childCount; c++)
+            {
+                interact(c, b, counts);
+            }
+        }
+    }
+    else
+    {
+        for (int c = B.firstChild; c < B.firstChild + B.childCount; c++)
+        {
+            interact(a, c, counts);
+        }
+    }
+}
+
+void FmmSolver::downward(int index)
+{
+    Cell &cell = cells[index];
+    if (cell.childCount == 0)
+    {
+        localToParticles(index);
+        return;
+    }
+
+    for (int c = cell.firstChild; c < cell.firstChild + cell.childCount; c++)
+    {
+        localToLocal(index, c);
+    }
+
+    if (cell.end - cell.begin > parallelThreshold)
+    {
+        pool.parallelFor(cell.childCount, 1, [&](std::size_t first, std::size_t last)
+                         {
+            for (std::size_t c = first; c < last; c++)
+            {
+                downward(cell.firstChild + (int)c);
+            } });
+    }
+    else
+    {
+        for (int c = cell.firstChild; c < cell.firstChild + cell.childCount; c++)
+        {
+            downward(c);
+        }
+    }
+}
+
+void FmmSolver::particleToMultipole(int index)
+{
+    Cell &cell = cells[index];
+
+    // Centre of mass, or the centroid for massless cells
+    double mass = 0.0;
+    for (int k = cell.begin; k < cell.end; k++)
+    {
+        mass += sortedMass[k];
+    }
+    double x = 0.0, y = 0.0, z = 0.0;
+    for (int k = cell.begin; k < cell.end; k++)
+    {
+        double weight = mass > 0.0 ? sortedMass[k] / mass : 1.0 / (cell.end - cell.begin);
+        x += weight * sortedX[k];
+        y += weight * sortedY[k];
+        z += weight * sortedZ[k];
+    }
+    cell.mass = mass;
+    cell.x = x;
+    cell.y = y;
+    cell.z = z;
+
+    Complex *M = &multipoles[(std::size_t)index * termCount];
+    Complex R[maxTerms];
+    double radius2 = 0.0;
+    for (int k = cell.begin; k < cell.end; k++)
+    {
+        double dx = sortedX[k] - cell.x, dy = sortedY[k] - cell.y, dz = sortedZ[k] - cell.z;
+        radius2 = std::max(radius2, dx * dx + dy * dy + dz * dz);
+
+        regularHarmonics(degree, dx, dy, dz, R);
+        for (int t = 0; t < termCount; t++)
+        {
+            M[t] += sortedMass[k] * R[t];
+        }
+    }
+    cell.radius = std::sqrt(radius2);
+}
+
+void FmmSolver::multipoleToMultipole(int child, int parent)
+{
+    const Cell &from = cells[child];
+    const Cell &to = cells[parent];
+    Complex *target = &multipoles[(std::size_t)parent * termCount];
+
+    Complex R[maxTerms];
+    regularHarmonics(degree, from.x - to.x, from.y - to.y, from.z - to.z, R);
+
+    double mRe[maxFullTerms], mIm[maxFullTerms], rRe[maxFullTerms], rIm[maxFullTerms];
+    unpack(degree, &multipoles[(std::size_t)child * termCount], mRe, mIm, false, false);
+    unpack(degree, R, rRe, rIm, false, false);
+
+    // M_n^m(parent) = sum M_k^l(child) R_(n-k)^(m-l)(child - parent)
+    for (int n = 0; n <= degree; n++)
+    {
+        for (int m = 0; m <= n; m++)
+        {
+            double sumRe = 0.0, sumIm = 0.0;
+            for (int k = 0; k <= n; k++)
+            {
+                int first = std::max(-k, m - (n - k)), last = std::min(k, m + (n - k));
+                for (int l = first; l <= last; l++)
+                {
+                    int a = fullIndex(k, l), b = fullIndex(n - k, m - l);
+                    sumRe += mRe[a] * rRe[b] - mIm[a] * rIm[b];
+                    sumIm += mRe[a] * rIm[b] + mIm[a] * rRe[b];
+                }
+            }
+            target[termIndex(n, m)] += Complex(sumRe, sumIm);
+        }
+    }
+}
+
+void FmmSolver::multipoleToLocal(int source, int target)
+{
+    const Cell &from = cells[source];
+    const Cell &to = cells[target];
+    Complex *L = &locals[(std::size_t)target * termCount];
+
+    Complex I[maxTerms];
+    irregularHarmonics(degree, from.x - to.x, from.y - to.y, from.z - to.z, I);
+
+    double mRe[maxFullTerms], mIm[maxFullTerms], iRe[maxFullTerms], iIm[maxFullTerms];
+    unpack(degree, &multipoles[(std::size_t)source * termCount], mRe, mIm, true, true);
+    unpack(degree, I, iRe, iIm, false, false);
+
+    // L_n^m(target) = sum (-1)^k conj(M_k^l) I_(n+k)^(m+l)(source - target);
+    // for each k the l terms are contiguous in both arrays
+    for (int n = 0; n <= degree; n++)
+    {
+        for (int m = 0; m <= n; m++)
+        {
+            double sumRe = 0.0, sumIm = 0.0;
+            for (int k = 0; k <= degree - n; k++)
+            {
+                const double *aRe = mRe + fullIndex(k, -k), *aIm = mIm + fullIndex(k, -k);
+                const double *bRe = iRe + fullIndex(n + k, m - k), *bIm = iIm + fullIndex(n + k, m - k);
+                for (int t = 0; t <= 2 * k; t++)
+                {
+                    sumRe += aRe[t] * bRe[t] - aIm[t] * bIm[t];
+                    sumIm += aRe[t] * bIm[t] + aIm[t] * bRe[t];
+                }
+            }
+            L[termIndex(n, m)] += Complex(sumRe, sumIm);
+        }
+    }
+}
+
+void FmmSolver::localToLocal(int parent, int child)
+{
+    const Cell &from = cells[parent];
+    const Cell &to = cells[child];
+    Complex *target = &locals[(std::size_t)child * termCount];
+
+    Complex R[maxTerms];
+    regularHarmonics(degree, to.x - from.x, to.y - from.y, to.z - from.z, R);
+
+    double rRe[maxFullTerms], rIm[maxFullTerms], lRe[maxFullTerms], lIm[maxFullTerms];
+    unpack(degree, R, rRe, rIm, true, false);
+    unpack(degree, &locals[(std::size_t)parent * termCount], lRe, lIm, false, false);
+
+    // L_j^q(child) = sum conj(R_k^l(child - parent)) L_(j+k)^(q+l)(parent)
+    for (int j = 0; j <= degree; j++)
+    {
+        for (int q = 0; q <= j; q++)
+        {
+            double sumRe = 0.0, sumIm = 0.0;
+            for (int k = 0; k <= degree - j; k++)
+            {
+                const double *aRe = rRe + fullIndex(k, -k), *aIm = rIm + fullIndex(k, -k);
+                const double *bRe = lRe + fullIndex(j + k, q - k), *bIm = lIm + fullIndex(j + k, q - k);
+                for (int t = 0; t <= 2 * k; t++)
+                {
+                    sumRe += aRe[t] * bRe[t] - aIm[t] * bIm[t];
+                    sumIm += aRe[t] * bIm[t] + aIm[t] * bRe[t];
+                }
+            }
+            target[termIndex(j, q)] += Complex(sumRe, sumIm);
+        }
+    }
+}
+
+void FmmSolver::localToParticles(int index)
+{
+    const Cell &cell = cells[index];
+
+    double lRe[maxFullTerms], lIm[maxFullTerms], rRe[maxFullTerms], rIm[maxFullTerms];
+    unpack(degree, &locals[(std::size_t)index * termCount], lRe, lIm, false, false);
+
+    // Shift the expansion to each particle, keeping degrees 0 and 1: the
+    // potential sum is Re L_0^0 and its gradient is (-Re L_1^1, -Im L_1^1, Re L_1^0)
+    Complex R[maxTerms];
+    for (int k = cell.begin; k < cell.end; k++)
+    {
+        regularHarmonics(degree, sortedX[k] - cell.x, sortedY[k] - cell.y, sortedZ[k] - cell.z, R);
+        unpack(degree, R, rRe, rIm, true, false);
+
+        double l00 = 0.0, l10 = 0.0, l11Re = 0.0, l11Im = 0.0;
+        for (int n = 0; n <= degree; n++)
+        {
+            for (int m = -n; m <= n; m++)
+            {
+                int a = fullIndex(n, m);
+                l00 += rRe[a] * lRe[a] - rIm[a] * lIm[a];
+                if (n < degree)
+                {
+                    int b = fullIndex(n + 1, m), c = fullIndex(n + 1, m + 1);
+                    l10 += rRe[a] * lRe[b] - rIm[a] * lIm[b];
+                    l11Re += rRe[a] * lRe[c] - rIm[a] * lIm[c];
+                    l11Im += rRe[a] * lIm[c] + rIm[a] * lRe[c];
+                }
+            }
+        }
+
+        accX[k] -= l11Re;
+        accY[k] -= l11Im;
+        accZ[k] += l10;
+        potential[k] -= l00;
+    }
+}
+
+void FmmSolver::particlesToParticles(int target, int source)
+{
+    const Cell &A = cells[target];
+    const Cell &B = cells[source];
+    const double selfSoftening = softeningLength();
+
+    // Includes each particle's own term when target == source; see computeForces
+    accumulatePairs(sortedX.data(), sortedY.data(), sortedZ.data(), sortedMass.data(),
+                    accX.data(), accY.data(), accZ.data(), potential.data(),
+                    A.begin, A.end, B.begin, B.end, selfSoftening * selfSoftening);
+}
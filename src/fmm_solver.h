@@ -0,0 +1,95 @@
+#pragma once
+
+#include "gravity_solver.h"
+#include "thread_pool.h"
+
+#include <complex>
+#include <cstdint>
+#include <vector>
+
+// Fast multipole method gravity (after Dehnen 2014). Particles are sorted
+// along a Morton curve into an adaptive octree; each cell carries a multipole
+// expansion about its centre of mass, built bottom-up. A dual tree walk
+// translates the multipoles of well-separated cell pairs into local expansions
+// (M2L) and sums near pairs directly, then the local expansions are passed
+// down the tree and evaluated at the particles. The upward pass, the walk and
+// the downward pass all split large subtrees across the pool.
+//
+// Expansions use complex solid harmonics truncated at expansionOrder; the
+// force error falls roughly as openingAngle^(expansionOrder + 1). Softening
+// applies to the direct near-field sums only.
+class FmmSolver : public GravitySolver
+{
+public:
+    // Highest harmonic degree kept in the expansions
+    int expansionOrder = 5;
+
+    // Cells A and B interact through expansions when rA + rB < openingAngle * |zA - zB|.
+    // Higher orders allow wider angles than Barnes-Hut for the same error.
+    double openingAngle = 0.7;
+
+    // Particles per leaf before it is split
+    int leafSize = 64;
+
+    explicit FmmSolver(ThreadPool &pool);
+
+    const char *name() const override { return "FMM"; }
+    void computeForces(ParticleSystem &particles) override;
+
+    std::size_t cellCount() const { return cells.size(); }
+
+    // Interactions counted by the last call
+    std::size_t lastMultipoleToLocal = 0;
+    std::size_t lastParticlePairs = 0;
+
+    struct Cell
+    {
+        // Expansion centre (centre of mass) and the distance to its farthest particle
+        double x, y, z;
+        double radius;
+        double mass;
+
+        // Particle range in Morton order
+        int begin, end;
+
+        // Children are stored contiguously
+        int firstChild, childCount;
+    };
+
+private:
+    typedef std::complex<double> Complex;
+
+    struct Counts
+    {
+        std::size_t multipoleToLocal = 0;
+        std::size_t particlePairs = 0;
+    };
+
+    ThreadPool &pool;
+    std::vector<Cell> cells;
+
+    // expansionOrder clamped for the current call, and coefficients per expansion
+    int degree = 0;
+    int termCount = 0;
+
+    // Coefficients with m >= 0, termCount per cell; m < 0 follows by symmetry
+    std::vector<Complex> multipoles;
+    std::vector<Complex> locals;
+
+    std::vector<std::uint64_t> codes;
+    std::vector<int> order;
+    AlignedVector<double> sortedX, sortedY, sortedZ, sortedMass;
+    AlignedVector<double> accX, accY, accZ, potential;
+
+    void buildCells(int index, int level);
+    void upward(int index);
+    void interact(int a, int b, Counts &counts);
+    void downward(int index);
+
+    void particleToMultipole(int index);
+    void multipoleToMultipole(int child, int parent);
+    void multipoleToLocal(int source, int target);
+    void localToLocal(int parent, int child);
+    void localToParticles(int index);
+    void particlesToParticles(int target, int source);
+};
@@ -0,0 +1,210 @@
+#include "frustum_culling.h"
+
+#include <algorithm>
+
+Frustum Frustum::fromMatrix(const glm::mat4 &viewProjection)
+{
+    // Rows of the matrix; each plane is the fourth row plus or minus another (Gribb and Hartmann)
+    glm::vec4 rows[4];
+    for (int r = 0; r < 4; r++)
+    {
+        rows[r] = glm::vec4(viewProjection[0][r], viewProjection[1][r], viewProjection[2][r], viewProjection[3][r]);
+    }
+
+    Frustum frustum;
+    frustum.planes[0] = rows[3] + rows[0]; // left
+    frustum.planes[1] = rows[3] - rows[0]; // right
+    frustum.planes[2] = rows[3] + rows[1]; // bottom
+    frustum.planes[3] = rows[3] - rows[1]; // top
+    frustum.planes[4] = rows[3] + rows[2]; // near
+    frustum.planes[5] = rows[3] - rows[2]; // far
+
+    for (glm::vec4 &plane : frustum.planes)
+    {
+        plane /= glm::length(glm::vec3(plane));
+    }
+    return frustum;
+}
+
+void FrustumCuller::build(const BodyStore &store, float boundScale)
+{
+    const std::size_t n = store.size();
+    childStart.assign(n + 1, 0);
+    for (std::size_t i = 0; i < n; i++)
+    {
+        if (store.parent[i] != BodyStore::NoParent)
+        {
+            childStart[(std::size_t)store.parent[i] + 1]++;
+        }
+    }
+    for (std::size_t i = 0; i < n; i++)
+    {
+        childStart[i + 1] += childStart[i];
+    }
+
+    roots.clear();
+    for (std::size_t i = 0; i < n; i++)
+    {
+        if (store.parent[i] == BodyStore::NoParent)
+        {
+            roots.push_back((int)i);
+        }
+    }
+
+    // Counting sort by parent keeps each body's children in index order
+    std::vector<int> fill(childStart.begin(), childStart.end() - 1);
+    childList.resize((std::size_t)childStart[n]);
+    for (std::size_t i = 0; i < n; i++)
+    {
+        if (store.parent[i] != BodyStore::NoParent)
+        {
+            childList[(std::size_t)fill[(std::size_t)store.parent[i]]++] = (int)i;
+        }
+    }
+
+    // Bodies are uniformly scaled unit spheres, so any column's length is the
+    // world scale, and spinning never changes it
+    AlignedVector<float> scale(n);
+    bodyRadius.resize(n);
+    systemRadius.resize(n);
+    for (std::size_t i = 0; i < n; i++)
+    {
+        scale[i] = glm::length(glm::vec3(store.worldMatrix[i][1]));
+        bodyRadius[i] = scale[i] * boundScale;
+        systemRadius[i] = bodyRadius[i];
+    }
+
+    // Children follow their parents, so walking backwards finishes every
+    // system bound before it is folded into its parent's. Orbits are measured
+    // in the parent's scaled frame.
+    for (std::size_t i = n; i-- > 0;)
+    {
+        int p = store.parent[i];
+        if (p == BodyStore::NoParent)
+        {
+            continue;
+        }
+        double distance = store.keplerOrbit[i] != BodyStore::NoKeplerOrbit
+                              ? store.keplerOrbits.maxDistance((std::size_t)store.keplerOrbit[i])
+                              : store.distanceFromParent[i];
+        float reach = (float)distance * scale[(std::size_t)p] + systemRadius[i];
+        systemRadius[(std::size_t)p] = std::max(systemRadius[(std::size_t)p], reach);
+    }
+    builtBoundScale = boundScale;
+}
+
+void FrustumCuller::testSpheres(const BodyStore &store, const Frustum &frustum, const std::vector<int> &indices,
+                                const AlignedVector<float> &radii)
+{
+    const std::size_t count = indices.size();
+    const std::size_t padded = (count + cullLanes - 1) / cullLanes * cullLanes;
+    sphereX.resize(padded);
+    sphereY.resize(padded);
+    sphereZ.resize(padded);
+    sphereRadius.resize(padded);
+    inside.resize(padded);
+
+    for (std::size_t k = 0; k < count; k++)
+    {
+        std::size_t i = (std::size_t)indices[k];
+        const glm::vec4 &center = store.renderMatrix[i][3];
+        sphereX[k] = center.x;
+        sphereY[k] = center.y;
+        sphereZ[k] = center.z;
+        sphereRadius[k] = radii[i];
+    }
+    for (std::size_t k = count; k < padded; k++)
+    {
+        sphereX[k] = sphereY[k] = sphereZ[k] = sphereRadius[k] = 0.0f;
+    }
+
+    for (std::size_t block = 0; block < padded; block += cullLanes)
+    {
+        const float *x = sphereX.data() + block;
+        const float *y = sphereY.data() + block;
+        const float *z = sphereZ.data() + block;
+        const float *r = sphereRadius.data() + block;
+
+        // Lane masks stay 32 bits wide, like the floats they come from, so no packing is needed
+        int in[cullLanes];
+        for (std::size_t l = 0; l < cullLanes; l++)
+        {
+            in[l] = 1;
+        }
+
+        // A sphere is outside when its centre is further than its radius behind any plane
+        for (const glm::vec4 &plane : frustum.planes)
+        {
+            for (std::size_t l = 0; l < cullLanes; l++)
+            {
+                float distance = plane.x * x[l] + plane.y * y[l] + plane.z * z[l] + plane.w;
+                in[l] &= distance >= -r[l] ? 1 : 0;
+            }
+        }
+
+        for (std::size_t l = 0; l < cullLanes; l++)
+        {
+            inside[block + l] = (unsigned char)in[l];
+        }
+    }
+    stats.sphereTests += count;
+}
+
+void FrustumCuller::cull(const BodyStore &store, const Frustum &frustum, float boundScale)
+{
+    stats = CullStats();
+    visible.clear();
+
+    // Bodies are only ever appended, so a new size means the hierarchy changed
+    if (childStart.size() != store.size() + 1 || builtBoundScale != boundScale)
+    {
+        build(store, boundScale);
+    }
+
+    frontier = roots;
+
+    while (!frontier.empty())
+    {
+        // Systems first: a rejected system takes all its descendants with it
+        testSpheres(store, frustum, frontier, systemRadius);
+        candidates.clear();
+        nextFrontier.clear();
+        for (std::size_t k = 0; k < frontier.size(); k++)
+        {
+            int body = frontier[k];
+            if (!inside[k])
+            {
+                stats.systemsCulled++;
+                continue;
+            }
+
+            // A body without children is its own system, so it has passed already
+            int first = childStart[(std::size_t)body], last = childStart[(std::size_t)body + 1];
+            if (first == last)
+            {
+                visible.push_back(body);
+                continue;
+            }
+            candidates.push_back(body);
+            for (int c = first; c < last; c++)
+            {
+                nextFrontier.push_back(childList[(std::size_t)c]);
+            }
+        }
+
+        // Then the bodies of the systems that survived
+        testSpheres(store, frustum, candidates, bodyRadius);
+        for (std::size_t k = 0; k < candidates.size(); k++)
+        {
+            if (inside[k])
+            {
+                visible.push_back(candidates[k]);
+            }
+        }
+
+        frontier.swap(nextFrontier);
+    }
+
+    stats.visible = visible.size();
+    stats.culled = store.size() - visible.size();
+}
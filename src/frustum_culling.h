@@ -0,0 +1,75 @@
+#pragma once
+
+#include "aligned_allocator.h"
+#include "body_store.h"
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <vector>
+
+// Six inward-facing planes (a, b, c, d) with unit normals; a point p is inside
+// a plane when a p.x + b p.y + c p.z + d >= 0
+struct Frustum
+{
+    glm::vec4 planes[6];
+
+    // Planes of a projection * view matrix, in the space the view matrix maps from
+    static Frustum fromMatrix(const glm::mat4 &viewProjection);
+};
+
+struct CullStats
+{
+    std::size_t visible = 0;
+    std::size_t culled = 0;
+
+    // Subtrees rejected by their system bound without testing their bodies
+    std::size_t systemsCulled = 0;
+
+    // Sphere-frustum tests run, system and body bounds together
+    std::size_t sphereTests = 0;
+};
+
+// Bounding-sphere frustum culling over a BodyStore's hierarchy. Each body has
+// its own bound and a system bound enclosing it and every place its descendants
+// can reach on their orbits. Starting from the roots, each level's system
+// bounds are tested first, so a planet whose system is outside the frustum is
+// rejected with every moon in one test and the moons are never looked at.
+// Spheres are tested in blocks of cullLanes against all six planes, laid out as
+// structure of arrays so the test vectorizes.
+class FrustumCuller
+{
+public:
+    // Bodies that passed, level by level
+    std::vector<int> visible;
+    CullStats stats;
+
+    // Cull against render-space bounds (BodyStore::renderMatrix). Body bounds are
+    // the scaled unit sphere times boundScale, for meshes drawn larger than the body.
+    void cull(const BodyStore &store, const Frustum &frustum, float boundScale = 1.0f);
+
+private:
+    // Children of every body, grouped by parent: childList[childStart[i] .. childStart[i + 1])
+    std::vector<int> childStart, childList;
+    std::vector<int> roots;
+
+    // Radii do not change as bodies move, so they are computed once, when the
+    // store's size or the bound scale changes (as UpdateScheduler rebuilds its levels)
+    AlignedVector<float> bodyRadius, systemRadius;
+    float builtBoundScale = 0.0f;
+
+    std::vector<int> frontier, nextFrontier, candidates;
+
+    // Spheres awaiting a test and the result for each
+    AlignedVector<float> sphereX, sphereY, sphereZ, sphereRadius;
+    AlignedVector<unsigned char> inside;
+
+    void build(const BodyStore &store, float boundScale);
+
+    // Test the spheres of the listed bodies, with system or body radii
+    void testSpheres(const BodyStore &store, const Frustum &frustum, const std::vector<int> &indices,
+                     const AlignedVector<float> &radii);
+};
+
+// Spheres per block in the plane test
+const std::size_t cullLanes = 8;
@@ -0,0 +1,36 @@
+#pragma once
+
+#include "particle_system.h"
+
+#include <algorithm>
+
+// Common interface for the gravity backends so integrators and the renderer
+// do not care how accelerations are computed
+class GravitySolver
+{
+public:
+    struct Timings
+    {
+        double buildSeconds = 0.0; // tree construction or other per-step setup
+        double forceSeconds = 0.0; // force and potential evaluation
+    };
+
+    double gravitationalConstant = 1.0;
+
+    // Plummer softening length; keeps close encounters finite
+    double softening = 0.01;
+
+    Timings lastTimings;
+
+    virtual ~GravitySolver() = default;
+    virtual const char *name() const = 0;
+
+    // Fill ax/ay/az and potential for every particle
+    virtual void computeForces(ParticleSystem &particles) = 0;
+
+protected:
+    // Softening for kernels that include each particle's interaction with itself
+    // rather than branch around it: with a non-zero length it adds no force and a
+    // known potential of -m / length, which is removed afterwards
+    double softeningLength() const { return std::max(softening, 1e-9); }
+};
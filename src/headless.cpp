@@ -0,0 +1,195 @@
+#include "headless.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+namespace
+{
+void printUsage(const char *program)
+{
+    std::cerr << "Usage: " << program << " [--headless] [--size WIDTHxHEIGHT] [--frames N] [--osmesa]\n"
+              << "       [--ray-cast] [--dump DIRECTORY] [--dump-every N]\n"
+              << "The other options apply only with --headless." << std::endl;
+}
+
+bool parsePositive(const char *text, int &value)
+{
+    char *end = nullptr;
+    long parsed = std::strtol(text, &end, 10);
+    if (end == text || *end != '\0' || parsed <= 0 || parsed > 1 << 20)
+    {
+        return false;
+    }
+    value = (int)parsed;
+    return true;
+}
+}
+
+bool parseHeadlessOptions(int argc, char **argv, HeadlessOptions &options)
+{
+    bool valid = true;
+    bool headlessOnly = false;
+    for (int i = 1; i < argc && valid; i++)
+    {
+        const char *arg = argv[i];
+        const char *value = i + 1 < argc ? argv[i + 1] : nullptr;
+        if (std::strcmp(arg, "--headless") == 0)
+        {
+            options.enabled = true;
+            continue;
+        }
+
+        headlessOnly = true;
+        if (std::strcmp(arg, "--osmesa") == 0)
+        {
+            options.osmesa = true;
+        }
+        else if (std::strcmp(arg, "--ray-cast") == 0)
+        {
+            options.rayCast = true;
+        }
+        else if (!value)
+        {
+            valid = false;
+        }
+        else if (std::strcmp(arg, "--size") == 0)
+        {
+            // WIDTHxHEIGHT
+            std::string size(value);
+            std::size_t x = size.find('x');
+            valid = x != std::string::npos && parsePositive(size.substr(0, x).c_str(), options.width) &&
+                    parsePositive(size.substr(x + 1).c_str(), options.height);
+            i++;
+        }
+        else if (std::strcmp(arg, "--frames") == 0)
+        {
+            valid = parsePositive(value, options.frames);
+            i++;
+        }
+        else if (std::strcmp(arg, "--dump") == 0)
+        {
+            options.dumpDirectory = value;
+            i++;
+        }
+        else if (std::strcmp(arg, "--dump-every") == 0)
+        {
+            valid = parsePositive(value, options.dumpEvery);
+            i++;
+        }
+        else
+        {
+            valid = false;
+        }
+
+        if (!valid)
+        {
+            std::cerr << "Bad argument: " << arg << std::endl;
+        }
+    }
+
+    if (valid && headlessOnly && !options.enabled)
+    {
+        std::cerr << "Offscreen options need --headless" << std::endl;
+        valid = false;
+    }
+    if (!valid)
+    {
+        printUsage(argc > 0 ? argv[0] : "SolarSystem");
+    }
+    return valid;
+}
+
+OffscreenTarget::OffscreenTarget(int width, int height)
+    : width(width), height(height)
+{
+    glGenRenderbuffers(1, &color);
+    glBindRenderbuffer(GL_RENDERBUFFER, color);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+
+    glGenRenderbuffers(1, &depth);
+    glBindRenderbuffer(GL_RENDERBUFFER, depth);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height);
+
+    glGenFramebuffers(1, &framebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, color);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, depth);
+    isComplete = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+}
+
+OffscreenTarget::~OffscreenTarget()
+{
+    destroy();
+}
+
+void OffscreenTarget::destroy()
+{
+    if (framebuffer == 0)
+    {
+        return;
+    }
+    glDeleteFramebuffers(1, &framebuffer);
+    glDeleteRenderbuffers(1, &color);
+    glDeleteRenderbuffers(1, &depth);
+    framebuffer = color = depth = 0;
+}
+
+void OffscreenTarget::bind() const
+{
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    glViewport(0, 0, width, height);
+}
+
+bool OffscreenTarget::writePpm(const std::string &path) const
+{
+    std::vector<unsigned char> pixels((std::size_t)width * height * 3);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(0, 0, width, height, GL_RGB, GL_UNSIGNED_BYTE, pixels.data());
+
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out)
+    {
+        return false;
+    }
+    out << "P6\n"
+        << width << " " << height << "\n255\n";
+
+    // GL rows run bottom to top, PPM rows top to bottom
+    const std::size_t rowBytes = (std::size_t)width * 3;
+    for (int row = height - 1; row >= 0; row--)
+    {
+        out.write((const char *)pixels.data() + (std::size_t)row * rowBytes, (std::streamsize)rowBytes);
+    }
+    return (bool)out;
+}
+
+void printFrameTimings(const std::vector<double> &frameSeconds, std::ostream &out)
+{
+    if (frameSeconds.empty())
+    {
+        return;
+    }
+
+    out << "frame\tms" << std::endl;
+    double total = 0.0;
+    for (std::size_t i = 0; i < frameSeconds.size(); i++)
+    {
+        out << i << "\t" << frameSeconds[i] * 1000.0 << std::endl;
+        total += frameSeconds[i];
+    }
+
+    std::vector<double> sorted(frameSeconds);
+    std::sort(sorted.begin(), sorted.end());
+    const std::size_t count = sorted.size();
+    double mean = total / (double)count;
+    double median = sorted[count / 2];
+    double p95 = sorted[std::min(count - 1, count * 95 / 100)];
+    out << "Frames: " << count << ", mean " << mean * 1000.0 << " ms (" << 1.0 / mean << " fps), median "
+        << median * 1000.0 << " ms, p95 " << p95 * 1000.0 << " ms, min " << sorted.front() * 1000.0 << " ms, max "
+        << sorted.back() * 1000.0 << " ms" << std::endl;
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include <cstddef>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Command-line settings for running without a display. Headless runs render a
+// fixed number of frames into an offscreen framebuffer at a fixed time step, so
+// two runs do the same work and their frame times can be compared.
+struct HeadlessOptions
+{
+    bool enabled = false;
+    int width = 1200, height = 800;
+    int frames = 300;
+
+    // Context from OSMesa instead of surfaceless EGL
+    bool osmesa = false;
+
+    // Start with ray-cast sphere impostors instead of meshes
+    bool rayCast = false;
+
+    // Write every dumpEvery-th frame as a PPM image here; empty for none
+    std::string dumpDirectory;
+    int dumpEvery = 1;
+};
+
+// Parse the options; false (after printing the problem and usage) on a bad argument
+bool parseHeadlessOptions(int argc, char **argv, HeadlessOptions &options);
+
+// Color and depth renderbuffers in a framebuffer object, standing in for the
+// window's default framebuffer when there is none
+class OffscreenTarget
+{
+public:
+    OffscreenTarget(int width, int height);
+    ~OffscreenTarget();
+
+    // Delete the framebuffer now, while the context is still current
+    void destroy();
+
+    OffscreenTarget(const OffscreenTarget &) = delete;
+    OffscreenTarget &operator=(const OffscreenTarget &) = delete;
+
+    bool complete() const { return isComplete; }
+    void bind() const;
+
+    // Save the current contents as a binary PPM, top row first
+    bool writePpm(const std::string &path) const;
+
+    int width, height;
+
+private:
+    GLuint framebuffer = 0, color = 0, depth = 0;
+    bool isComplete = false;
+};
+
+// Per-frame times followed by a summary line
+void printFrameTimings(const std::vector<double> &frameSeconds, std::ostream &out);
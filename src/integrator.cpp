@@ -0,0 +1,258 @@
+#include "integrator.h"
+
+#include <cmath>
+
+namespace
+{
+const int maxKeplerIterations = 50;
+const double keplerTolerance = 1e-13;
+
+void kick(ParticleSystem &particles, double dt)
+{
+    for (std::size_t i = 0; i < particles.size(); i++)
+    {
+        particles.vx[i] += particles.ax[i] * dt;
+        particles.vy[i] += particles.ay[i] * dt;
+        particles.vz[i] += particles.az[i] * dt;
+    }
+}
+
+void drift(ParticleSystem &particles, double dt)
+{
+    for (std::size_t i = 0; i < particles.size(); i++)
+    {
+        particles.x[i] += particles.vx[i] * dt;
+        particles.y[i] += particles.vy[i] * dt;
+        particles.z[i] += particles.vz[i] * dt;
+    }
+}
+
+// Stumpff functions c2(z) = (1 - cos sqrt z) / z and c3(z) = (sqrt z - sin sqrt z) / z^1.5,
+// continued for negative z (hyperbolic orbits); series near zero avoid cancellation
+void stumpff(double z, double &c2, double &c3)
+{
+    if (z > 1e-4)
+    {
+        double s = std::sqrt(z);
+        c2 = (1.0 - std::cos(s)) / z;
+        c3 = (s - std::sin(s)) / (z * s);
+    }
+    else if (z < -1e-4)
+    {
+        double s = std::sqrt(-z);
+        c2 = (std::cosh(s) - 1.0) / -z;
+        c3 = (std::sinh(s) - s) / (-z * s);
+    }
+    else
+    {
+        c2 = 1.0 / 2.0 - z / 24.0 + z * z / 720.0;
+        c3 = 1.0 / 6.0 - z / 120.0 + z * z / 5040.0;
+    }
+}
+
+// Advance one particle along its two-body orbit about mass mu = GM at the origin
+// for time dt, using universal variables and Lagrange's f and g (valid for any
+// eccentricity)
+void keplerDrift(double mu, double dt, double &x, double &y, double &z, double &vx, double &vy, double &vz)
+{
+    double r0 = std::sqrt(x * x + y * y + z * z);
+    double v2 = vx * vx + vy * vy + vz * vz;
+    double sqrtMu = std::sqrt(mu);
+    double rv = (x * vx + y * vy + z * vz) / sqrtMu;
+
+    // Reciprocal semi-major axis; negative for hyperbolic orbits
+    double alpha = 2.0 / r0 - v2 / mu;
+
+    // Solve the universal Kepler equation for chi with Newton's method
+    double chi = sqrtMu * std::fabs(alpha) * dt;
+    if (!(alpha > 0.0) || chi == 0.0)
+    {
+        chi = sqrtMu * dt / r0;
+    }
+
+    double c2 = 0.5, c3 = 1.0 / 6.0, r = r0;
+    for (int iteration = 0; iteration < maxKeplerIterations; iteration++)
+    {
+        double chi2 = chi * chi;
+        double psi = alpha * chi2;
+        stumpff(psi, c2, c3);
+
+        double t = rv * chi2 * c2 + (1.0 - alpha * r0) * chi2 * chi * c3 + r0 * chi;
+        r = rv * chi * (1.0 - psi * c3) + (1.0 - alpha * r0) * chi2 * c2 + r0;
+
+        double delta = (sqrtMu * dt - t) / r;
+        chi += delta;
+        if (std::fabs(delta) < keplerTolerance * (1.0 + std::fabs(chi)))
+        {
+            break;
+        }
+    }
+
+    double chi2 = chi * chi;
+    stumpff(alpha * chi2, c2, c3);
+
+    double f = 1.0 - chi2 / r0 * c2;
+    double g = dt - chi2 * chi * c3 / sqrtMu;
+
+    double nx = f * x + g * vx;
+    double ny = f * y + g * vy;
+    double nz = f * z + g * vz;
+    r = std::sqrt(nx * nx + ny * ny + nz * nz);
+
+    double fDot = sqrtMu / (r * r0) * chi * (alpha * chi2 * c3 - 1.0);
+    double gDot = 1.0 - chi2 / r * c2;
+
+    double nvx = fDot * x + gDot * vx;
+    double nvy = fDot * y + gDot * vy;
+    double nvz = fDot * z + gDot * vz;
+
+    x = nx;
+    y = ny;
+    z = nz;
+    vx = nvx;
+    vy = nvy;
+    vz = nvz;
+}
+}
+
+const char *integratorName(IntegratorMethod method)
+{
+    switch (method)
+    {
+    case IntegratorMethod::Leapfrog:
+        return "Leapfrog";
+    case IntegratorMethod::Yoshida4:
+        return "Yoshida 4";
+    case IntegratorMethod::WisdomHolman:
+        return "Wisdom-Holman";
+    }
+    return "Unknown";
+}
+
+FixedStepIntegrator::FixedStepIntegrator(GravitySolver &solver)
+    : solver(&solver)
+{
+}
+
+void FixedStepIntegrator::setSolver(GravitySolver &newSolver)
+{
+    solver = &newSolver;
+    primed = false;
+}
+
+int FixedStepIntegrator::advance(ParticleSystem &particles, double frameTime)
+{
+    accumulator += frameTime;
+
+    int steps = 0;
+    while (accumulator >= timeStep && steps < maxStepsPerFrame)
+    {
+        step(particles);
+        accumulator -= timeStep;
+        steps++;
+    }
+
+    // Drop whatever could not be caught up this frame
+    if (accumulator >= timeStep)
+    {
+        accumulator = std::fmod(accumulator, timeStep);
+    }
+    return steps;
+}
+
+void FixedStepIntegrator::step(ParticleSystem &particles)
+{
+    if (!primed || primedMethod != method || primedCount != particles.size())
+    {
+        computeForces(particles);
+        primed = true;
+        primedMethod = method;
+        primedCount = particles.size();
+    }
+
+    switch (method)
+    {
+    case IntegratorMethod::Leapfrog:
+        leapfrog(particles, timeStep);
+        break;
+
+    case IntegratorMethod::Yoshida4:
+    {
+        // Triple jump: w1, w0, w1 with w1 = 1 / (2 - 2^(1/3)) and w0 = 1 - 2 w1
+        const double cubeRootTwo = std::cbrt(2.0);
+        const double w1 = 1.0 / (2.0 - cubeRootTwo);
+        const double w0 = -cubeRootTwo * w1;
+        leapfrog(particles, w1 * timeStep);
+        leapfrog(particles, w0 * timeStep);
+        leapfrog(particles, w1 * timeStep);
+        break;
+    }
+
+    case IntegratorMethod::WisdomHolman:
+        wisdomHolman(particles, timeStep);
+        break;
+    }
+}
+
+double FixedStepIntegrator::energy(const ParticleSystem &particles) const
+{
+    double total = particles.totalEnergy();
+    if (centralMass > 0.0)
+    {
+        double mu = solver->gravitationalConstant * centralMass;
+        for (std::size_t i = 0; i < particles.size(); i++)
+        {
+            double r = std::sqrt(particles.x[i] * particles.x[i] + particles.y[i] * particles.y[i] + particles.z[i] * particles.z[i]);
+            total -= mu * particles.mass[i] / r;
+        }
+    }
+    return total;
+}
+
+void FixedStepIntegrator::computeForces(ParticleSystem &particles)
+{
+    solver->computeForces(particles);
+    evaluations++;
+
+    // Wisdom-Holman integrates the central pull in its drift; the others need it as a force
+    if (centralMass > 0.0 && method != IntegratorMethod::WisdomHolman)
+    {
+        double mu = solver->gravitationalConstant * centralMass;
+        for (std::size_t i = 0; i < particles.size(); i++)
+        {
+            double r2 = particles.x[i] * particles.x[i] + particles.y[i] * particles.y[i] + particles.z[i] * particles.z[i];
+            double scale = -mu / (r2 * std::sqrt(r2));
+            particles.ax[i] += particles.x[i] * scale;
+            particles.ay[i] += particles.y[i] * scale;
+            particles.az[i] += particles.z[i] * scale;
+        }
+    }
+}
+
+void FixedStepIntegrator::leapfrog(ParticleSystem &particles, double dt)
+{
+    kick(particles, 0.5 * dt);
+    drift(particles, dt);
+    computeForces(particles);
+    kick(particles, 0.5 * dt);
+}
+
+void FixedStepIntegrator::wisdomHolman(ParticleSystem &particles, double dt)
+{
+    // With no central mass the Kepler drift is a straight line and this is leapfrog
+    if (!(centralMass > 0.0))
+    {
+        leapfrog(particles, dt);
+        return;
+    }
+
+    double mu = solver->gravitationalConstant * centralMass;
+
+    kick(particles, 0.5 * dt);
+    for (std::size_t i = 0; i < particles.size(); i++)
+    {
+        keplerDrift(mu, dt, particles.x[i], particles.y[i], particles.z[i], particles.vx[i], particles.vy[i], particles.vz[i]);
+    }
+    computeForces(particles);
+    kick(particles, 0.5 * dt);
+}
@@ -0,0 +1,204 @@
+#include "kepler.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+const double twoPi = 6.28318530717958647692;
+const double toRadians = 3.14159265358979323846 / 180.0;
+
+// Bodies solved together; loops over a batch map onto SIMD lanes
+const std::size_t batchSize = 8;
+const int maxNewtonIterations = 8;
+const double tolerance = 1e-12;
+
+// Round to nearest by adding and removing 1.5 * 2^52. Unlike std::floor this is
+// plain arithmetic, so it vectorizes without relaxed floating-point flags
+// (it must not be built with -ffast-math, which would fold it away). Valid for |x| < 2^51.
+inline double roundToNearest(double x)
+{
+    const double shifter = 6755399441055744.0;
+    return (x + shifter) - shifter;
+}
+
+// Branch-free sine and cosine (Cody-Waite reduction to [-pi/4, pi/4] plus the
+// fdlibm kernels). Quadrant fix-ups are selects rather than branches, so loops
+// calling this vectorize where std::sin/std::cos would not.
+inline void sinCos(double x, double &s, double &c)
+{
+    const double twoOverPi = 6.36619772367581382433e-01;
+    const double pio2Hi = 1.57079632673412561417e+00;
+    const double pio2Lo = 6.07710050650619224932e-11;
+
+    double q = roundToNearest(x * twoOverPi);
+    double r = (x - q * pio2Hi) - q * pio2Lo;
+    double z = r * r;
+
+    double sr = r + r * z * (-1.66666666666666324348e-01 + z * (8.33333333332248946124e-03 + z * (-1.98412698298579493134e-04 + z * (2.75573137070700676789e-06 + z * (-2.50507602534068634195e-08 + z * 1.58969099521155010221e-10)))));
+    double cr = 1.0 - 0.5 * z + z * z * (4.16666666666666019037e-02 + z * (-1.38888888888741095749e-03 + z * (2.48015872894767294178e-05 + z * (-2.75573143513906633035e-07 + z * (2.08757232129817482790e-09 + z * -1.13596475577881948265e-11)))));
+
+    // Quadrant 0..3 (q is an integer, so the offsets turn rounding into floor);
+    // single comparisons keep every select if-convertible
+    double quadrant = q - 4.0 * roundToNearest(q * 0.25 - 0.375);
+    bool swap = quadrant - 2.0 * roundToNearest(quadrant * 0.5 - 0.25) == 1.0;
+    double sinValue = swap ? cr : sr;
+    double cosValue = swap ? sr : cr;
+    s = quadrant >= 2.0 ? -sinValue : sinValue;
+    c = std::fabs(quadrant - 1.5) < 1.0 ? -cosValue : cosValue;
+}
+
+// Newton's method on up to batchSize bodies. Every lane runs the same
+// iteration; the batch stops once all lanes have converged.
+inline void solveBatch(const double *meanAnomaly, const double *eccentricity, double *eccentricAnomaly, std::size_t count)
+{
+    double M[batchSize], e[batchSize], E[batchSize];
+
+    for (std::size_t l = 0; l < batchSize; l++)
+    {
+        // Pad short batches with a trivially converged orbit
+        M[l] = l < count ? meanAnomaly[l] : 0.0;
+        e[l] = l < count ? eccentricity[l] : 0.0;
+    }
+
+    for (std::size_t l = 0; l < batchSize; l++)
+    {
+        // Wrap into [-pi, pi] and start from M + 0.85 e sign(sin M), which converges for all e < 1
+        M[l] -= twoPi * roundToNearest(M[l] * (1.0 / twoPi));
+        E[l] = M[l] + (M[l] < 0.0 ? -0.85 : 0.85) * e[l];
+    }
+
+    for (int iteration = 0; iteration < maxNewtonIterations; iteration++)
+    {
+        double step[batchSize];
+        for (std::size_t l = 0; l < batchSize; l++)
+        {
+            double s, c;
+            sinCos(E[l], s, c);
+            step[l] = (E[l] - e[l] * s - M[l]) / (1.0 - e[l] * c);
+            E[l] -= step[l];
+        }
+
+        // Kept out of the loop above: a floating-point max reduction would stop it vectorizing
+        bool converged = true;
+        for (std::size_t l = 0; l < batchSize; l++)
+        {
+            converged &= std::fabs(step[l]) < tolerance;
+        }
+        if (converged)
+        {
+            break;
+        }
+    }
+
+    for (std::size_t l = 0; l < count; l++)
+    {
+        eccentricAnomaly[l] = E[l];
+    }
+}
+}
+
+void solveKeplerBatch(const double *meanAnomaly, const double *eccentricity,
+                      double *eccentricAnomaly, std::size_t count)
+{
+    for (std::size_t i = 0; i < count; i += batchSize)
+    {
+        solveBatch(meanAnomaly + i, eccentricity + i, eccentricAnomaly + i, std::min(batchSize, count - i));
+    }
+}
+
+int KeplerOrbits::add(const OrbitalElements &elements)
+{
+    int index = (int)size();
+
+    double a = elements.semiMajorAxis;
+    double e = elements.eccentricity;
+    double inc = elements.inclination * toRadians;
+    double node = elements.longitudeOfAscendingNode * toRadians;
+    double peri = elements.argumentOfPeriapsis * toRadians;
+
+    semiMajorAxis.push_back(a);
+    semiMinorAxis.push_back(a * std::sqrt(1.0 - e * e));
+    eccentricity.push_back(e);
+    meanAnomalyAtEpoch.push_back(elements.meanAnomalyAtEpoch * toRadians);
+
+    // Same pace as the circular orbits: half a revolution per period of real time
+    meanMotion.push_back(elements.period > 0 ? 0.5 * twoPi / elements.period : 0.0);
+
+    // Perifocal basis in ecliptic coordinates (x, y, z) ...
+    double cosNode = std::cos(node), sinNode = std::sin(node);
+    double cosPeri = std::cos(peri), sinPeri = std::sin(peri);
+    double cosInc = std::cos(inc), sinInc = std::sin(inc);
+
+    double pEx = cosNode * cosPeri - sinNode * sinPeri * cosInc;
+    double pEy = sinNode * cosPeri + cosNode * sinPeri * cosInc;
+    double pEz = sinPeri * sinInc;
+    double qEx = -cosNode * sinPeri - sinNode * cosPeri * cosInc;
+    double qEy = -sinNode * sinPeri + cosNode * cosPeri * cosInc;
+    double qEz = cosPeri * sinInc;
+
+    // ... mapped to render space, where the ecliptic is XZ and +Y is north: (x, z, -y)
+    px.push_back(pEx);
+    py.push_back(pEz);
+    pz.push_back(-pEy);
+    qx.push_back(qEx);
+    qy.push_back(qEz);
+    qz.push_back(-qEy);
+
+    positionX.push_back(0.0);
+    positionY.push_back(0.0);
+    positionZ.push_back(0.0);
+    evaluate(0.0, index, index + 1);
+
+    return index;
+}
+
+void KeplerOrbits::clear()
+{
+    positionX.clear();
+    positionY.clear();
+    positionZ.clear();
+    semiMajorAxis.clear();
+    semiMinorAxis.clear();
+    eccentricity.clear();
+    meanAnomalyAtEpoch.clear();
+    meanMotion.clear();
+    px.clear();
+    py.clear();
+    pz.clear();
+    qx.clear();
+    qy.clear();
+    qz.clear();
+}
+
+void KeplerOrbits::evaluate(double time, std::size_t begin, std::size_t end)
+{
+    double M[batchSize], E[batchSize];
+
+    for (std::size_t i = begin; i < end; i += batchSize)
+    {
+        std::size_t count = std::min(batchSize, end - i);
+
+        for (std::size_t l = 0; l < count; l++)
+        {
+            M[l] = meanAnomalyAtEpoch[i + l] + meanMotion[i + l] * time;
+        }
+
+        solveBatch(M, eccentricity.data() + i, E, count);
+
+        for (std::size_t l = 0; l < count; l++)
+        {
+            std::size_t k = i + l;
+            double s, c;
+            sinCos(E[l], s, c);
+
+            // Position in the orbital plane, relative to the focus
+            double xp = semiMajorAxis[k] * (c - eccentricity[k]);
+            double yp = semiMinorAxis[k] * s;
+
+            positionX[k] = px[k] * xp + qx[k] * yp;
+            positionY[k] = py[k] * xp + qy[k] * yp;
+            positionZ[k] = pz[k] * xp + qz[k] * yp;
+        }
+    }
+}
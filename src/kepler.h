@@ -0,0 +1,59 @@
+#pragma once
+
+#include "aligned_allocator.h"
+
+#include <cstddef>
+
+// Classical orbital elements. Angles are in degrees, the period is in the same
+// simulation units as CelestialBody orbital periods.
+struct OrbitalElements
+{
+    double semiMajorAxis;
+    double eccentricity;
+    double inclination;
+    double longitudeOfAscendingNode;
+    double argumentOfPeriapsis;
+    double meanAnomalyAtEpoch;
+    double period;
+};
+
+// Analytic (closed-form) elliptical orbits stored as structure-of-arrays.
+// Positions are evaluated directly from the simulation time, so seeking to any
+// time costs the same and no error accumulates from frame to frame.
+class KeplerOrbits
+{
+public:
+    // Positions relative to the parent body, in render coordinates (+Y up).
+    // The orbital plane for zero inclination is XZ, matching the circular orbits.
+    // Kept in double so orbits at real astronomical distances stay exact.
+    AlignedVector<double> positionX;
+    AlignedVector<double> positionY;
+    AlignedVector<double> positionZ;
+
+    int add(const OrbitalElements &elements);
+    void clear();
+    std::size_t size() const { return eccentricity.size(); }
+
+    // Farthest the orbit ever gets from its parent (the apoapsis distance)
+    double maxDistance(std::size_t orbit) const { return semiMajorAxis[orbit] * (1.0 + eccentricity[orbit]); }
+
+    // Evaluate orbits [begin, end) at the given time (seconds since epoch)
+    void evaluate(double time, std::size_t begin, std::size_t end);
+    void evaluate(double time) { evaluate(time, 0, size()); }
+
+private:
+    AlignedVector<double> semiMajorAxis;
+    AlignedVector<double> semiMinorAxis;
+    AlignedVector<double> eccentricity;
+    AlignedVector<double> meanAnomalyAtEpoch;
+    AlignedVector<double> meanMotion;
+
+    // Perifocal basis vectors P (towards periapsis) and Q, already rotated into render space
+    AlignedVector<double> px, py, pz;
+    AlignedVector<double> qx, qy, qz;
+};
+
+// Solve Kepler's equation E - e sin(E) = M for count bodies at once using
+// Newton iterations that run side by side in SIMD lanes
+void solveKeplerBatch(const double *meanAnomaly, const double *eccentricity,
+                      double *eccentricAnomaly, std::size_t count);
@@ -0,0 +1,57 @@
+#pragma once
+
+// Branch-free math shared by the per-instruction-set kernel files. Everything
+// here is static so each file keeps its own copy built with its own flags, and
+// none of it may call into the standard library (see belt_kernels.h).
+
+#include <cstdint>
+
+// Round to nearest by adding and removing 1.5 * 2^52 (1.5 * 2^23 for floats),
+// which vectorizes where std::floor would not. Must not be built with -ffast-math.
+static inline double roundToNearest(double x)
+{
+    const double shifter = 6755399441055744.0;
+    return (x + shifter) - shifter;
+}
+
+static inline float roundToNearest(float x)
+{
+    const float shifter = 12582912.0f;
+    return (x + shifter) - shifter;
+}
+
+// Branch-free single-precision sine and cosine (three-part Cody-Waite reduction
+// to [-pi/4, pi/4] plus the Cephes sinf/cosf polynomials), with the same
+// select-based quadrant fix-up as the double version in kepler.cpp
+static inline void sinCos(float x, float &s, float &c)
+{
+    const float twoOverPi = 0.636619772367581343f;
+    const float pio2A = 1.5703125f;
+    const float pio2B = 4.837512969970703125e-4f;
+    const float pio2C = 7.54978995489188216e-8f;
+
+    float q = roundToNearest(x * twoOverPi);
+    float r = ((x - q * pio2A) - q * pio2B) - q * pio2C;
+    float z = r * r;
+
+    float sr = r + r * z * (-1.6666654611e-1f + z * (8.3321608736e-3f + z * -1.9515295891e-4f));
+    float cr = 1.0f - 0.5f * z + z * z * (4.166664568298827e-2f + z * (-1.388731625493765e-3f + z * 2.443315711809948e-5f));
+
+    float quadrant = q - 4.0f * roundToNearest(q * 0.25f - 0.375f);
+    bool swap = quadrant - 2.0f * roundToNearest(quadrant * 0.5f - 0.25f) == 1.0f;
+    float sinValue = swap ? cr : sr;
+    float cosValue = swap ? sr : cr;
+    s = quadrant >= 2.0f ? -sinValue : sinValue;
+    c = quadrant > 0.5f && quadrant < 2.5f ? -cosValue : cosValue;
+}
+
+// PCG hash (Jarzynski and Olano, "Hash Functions for GPU Rendering"): one
+// round of a PCG generator used as a stateless permutation of 32-bit values.
+// Random numbers drawn as hash(key + index) can be produced in any order, or
+// many lanes at once, and always come out the same.
+static inline std::uint32_t pcgHash(std::uint32_t value)
+{
+    std::uint32_t state = value * 747796405u + 2891336453u;
+    std::uint32_t word = ((state >> ((state >> 28) + 4)) ^ state) * 277803737u;
+    return (word >> 22) ^ word;
+}
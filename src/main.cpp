@@ -7,7 +7,28 @@
 #include <vector>
 #include <cmath>
 #include <cstdlib>
-#include <ctime>
+#include <cstdio>
+#include <filesystem>
+#include <memory>
+
+#include "barnes_hut.h"
+#include "belt_particles.h"
+#include "body_store.h"
+#include "direct_solver.h"
+#include "fmm_solver.h"
+#include "frustum_culling.h"
+#include "headless.h"
+#include "integrator.h"
+#include "particle_system.h"
+#include "procedural_texture.h"
+#include "program_cache.h"
+#include "shader_program.h"
+#include "shader_variants.h"
+#include "sphere_lod.h"
+#include "texture_array_pool.h"
+#include "texture_cache.h"
+#include "thread_pool.h"
+#include "update_scheduler.h"
 
 // TODO: Add STB Image library for real texture loading
 // #define STB_IMAGE_IMPLEMENTATION
@@ -17,189 +38,61 @@
 #define M_PI 3.14159265358979323846
 #endif
 
-// Enhanced procedural texture loading function with more realistic patterns
-unsigned int createProceduralTexture(const std::string &name)
-{
-    unsigned int textureID;
-    glGenTextures(1, &textureID);
-    glBindTexture(GL_TEXTURE_2D, textureID);
-
-    const int width = 512, height = 512;
-    std::vector<unsigned char> data(width * height * 3);
-
-    // Initialize random seed for this texture
-    srand(std::hash<std::string>{}(name));
-
-    for (int y = 0; y < height; y++)
-    {
-        for (int x = 0; x < width; x++)
-        {
-            int index = (y * width + x) * 3;
-            float u = (float)x / width;
-            float v = (float)y / height;
-
-            if (name == "Sun")
-            {
-                // Sun texture - solar surface with granules and sunspots
-                float noise = (float)(rand() % 100) / 100.0f;
-                float granule = sin(u * 50) * cos(v * 50) * 0.1f;
-
-                // Base solar color
-                int r = 255;
-                int g = 220 + (int)(noise * 35) + (int)(granule * 255);
-                int b = 150 + (int)(noise * 50);
-
-                // Add sunspots (dark regions)
-                float sunspot = sin(u * 3.14f) * sin(v * 2.1f);
-                if (sunspot > 0.8f && noise > 0.95f)
-                {
-                    r = 180;
-                    g = 150;
-                    b = 100;
-                }
-
-                data[index] = r;
-                data[index + 1] = g;
-                data[index + 2] = b;
-            }
-            else if (name == "Earth")
-            {
-                // Earth texture - continents, oceans, clouds
-                float noise = (float)(rand() % 100) / 100.0f;
-                float continent = sin(u * 8) * cos(v * 6) + sin(u * 12) * cos(v * 9);
-
-                if (continent > 0.3f)
-                {
-                    // Land - green/brown continents
-                    data[index] = 50 + (int)(noise * 100);
-                    data[index + 1] = 120 + (int)(noise * 80);
-                    data[index + 2] = 50 + (int)(noise * 50);
-                }
-                else
-                {
-                    // Ocean - blue water
-                    data[index] = 20 + (int)(noise * 30);
-                    data[index + 1] = 80 + (int)(noise * 60);
-                    data[index + 2] = 150 + (int)(noise * 50);
-                }
-
-                // Add white clouds
-                if (noise > 0.85f)
-                {
-                    data[index] = 200;
-                    data[index + 1] = 200;
-                    data[index + 2] = 200;
-                }
-            }
-            else if (name == "Mars")
-            {
-                // Mars texture - red surface with craters and dust
-                float noise = (float)(rand() % 100) / 100.0f;
-                float crater = sin(u * 20) * cos(v * 15) + sin(u * 30) * cos(v * 25);
+// Every body texture is this size, so they can share one texture array
+const int bodyTextureSize = 512;
 
-                // Base red surface
-                int r = 180 + (int)(noise * 40);
-                int g = 80 + (int)(noise * 30);
-                int b = 40 + (int)(noise * 20);
+// Frame-constant data shared by every program, in a std140 uniform block
+struct FrameUniforms
+{
+    glm::mat4 view;
+    glm::mat4 projection;
+    glm::vec4 lightPos;
+    glm::vec4 lightColor;
+    glm::vec4 viewPos;
+};
 
-                // Add craters (darker regions)
-                if (crater > 0.7f)
-                {
-                    r = 120;
-                    g = 50;
-                    b = 20;
-                }
+const GLuint frameUniformBinding = 0;
 
-                data[index] = r;
-                data[index + 1] = g;
-                data[index + 2] = b;
-            }
-            else if (name == "Jupiter")
-            {
-                // Jupiter texture - gas giant with bands and storms
-                float band = sin(v * 20) * 0.5f + 0.5f;
-                float storm = sin(u * 15) * cos(v * 10);
+// Per-body data streamed into a texture buffer each frame (GL 3.3 has no
+// storage buffers), fetched by gl_InstanceID: eight RGBA32F texels per body
+struct ObjectData
+{
+    glm::mat4 model;
 
-                // Alternating bands
-                if (band > 0.5f)
-                {
-                    data[index] = 200;
-                    data[index + 1] = 150;
-                    data[index + 2] = 100; // Light band
-                }
-                else
-                {
-                    data[index] = 160;
-                    data[index + 1] = 100;
-                    data[index + 2] = 60; // Dark band
-                }
+    // Normal matrix columns in xyz; the first w holds the texture layer
+    glm::vec4 normalMatrix[3];
 
-                // Add Great Red Spot
-                float redSpot = sqrt((u - 0.7f) * (u - 0.7f) + (v - 0.5f) * (v - 0.5f));
-                if (redSpot < 0.1f)
-                {
-                    data[index] = 180;
-                    data[index + 1] = 80;
-                    data[index + 2] = 60;
-                }
-            }
-            else if (name == "Saturn")
-            {
-                // Saturn texture - pale bands with subtle rings shadow
-                float band = sin(v * 15) * 0.3f + 0.7f;
+    // Object colour in rgb
+    glm::vec4 color;
+};
 
-                data[index] = 200 + (int)(band * 30);
-                data[index + 1] = 180 + (int)(band * 20);
-                data[index + 2] = 140 + (int)(band * 20);
-            }
-            else if (name == "Uranus")
-            {
-                // Uranus texture - pale blue-green with subtle bands
-                float band = sin(v * 10) * 0.2f + 0.8f;
+const int objectDataTexels = sizeof(ObjectData) / sizeof(glm::vec4);
 
-                data[index] = 120 + (int)(band * 20);
-                data[index + 1] = 160 + (int)(band * 30);
-                data[index + 2] = 180 + (int)(band * 20);
-            }
-            else if (name == "Neptune")
-            {
-                // Neptune texture - deep blue with white clouds
-                float noise = (float)(rand() % 100) / 100.0f;
-                float cloud = sin(u * 8) * cos(v * 6);
+// Material features that select a sphere program variant; bit i defines sphereFeatureNames[i]
+enum SphereFeature : unsigned
+{
+    SphereTextured = 1,
+    SphereEmissive = 2
+};
+const char *const sphereFeatureNames[] = {"TEXTURED", "EMISSIVE"};
+const std::size_t sphereFeatureCount = 2;
+const unsigned sphereVariantCount = 1u << sphereFeatureCount;
 
-                data[index] = 60 + (int)(noise * 20);
-                data[index + 1] = 100 + (int)(noise * 30);
-                data[index + 2] = 180 + (int)(noise * 40);
+// Uniform handles and one-time setup for every sphere program variant. Samplers
+// read the body textures from unit 0 and the object buffer from unit 1.
+struct SphereBindings
+{
+    Uniform<int> firstInstance;
+    Uniform<float> pixelScale;
 
-                // Add white clouds
-                if (cloud > 0.8f && noise > 0.7f)
-                {
-                    data[index] = 200;
-                    data[index + 1] = 200;
-                    data[index + 2] = 200;
-                }
-            }
-            else
-            {
-                // Default texture for other planets
-                float noise = (float)(rand() % 100) / 100.0f;
-                data[index] = 128 + (int)(noise * 127);
-                data[index + 1] = 128 + (int)(noise * 127);
-                data[index + 2] = 128 + (int)(noise * 127);
-            }
-        }
+    explicit SphereBindings(ShaderProgram &program)
+        : firstInstance(program.uniform<int>("firstInstance")), pixelScale(program.uniform<float>("pixelScale"))
+    {
+        program.bindUniformBlock("FrameData", frameUniformBinding);
+        program.uniform<int>("diffuseTextures").set(0);
+        program.uniform<int>("objectData").set(1);
     }
-
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, data.data());
-    glGenerateMipmap(GL_TEXTURE_2D);
-
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-    return textureID;
-}
+};
 
 // Vertex Shader source code for 3D
 const char *vertexShaderSource = R"(
@@ -207,114 +100,420 @@ const char *vertexShaderSource = R"(
     layout (location = 0) in vec3 aPos;
     layout (location = 1) in vec3 aNormal;
     layout (location = 2) in vec2 aTexCoord;
-    
-    uniform mat4 model;
-    uniform mat4 view;
-    uniform mat4 projection;
-    
+
+    layout (std140) uniform FrameData
+    {
+        mat4 view;
+        mat4 projection;
+        vec4 lightPos;
+        vec4 lightColor;
+        vec4 viewPos;
+    };
+
+    uniform samplerBuffer objectData;
+
+    // Instances are drawn in one batch per LOD level; this is the batch's first object
+    uniform int firstInstance;
+
     out vec3 FragPos;
     out vec3 Normal;
     out vec2 TexCoord;
-    
+    flat out vec3 ObjectColor;
+    flat out float TextureLayer;
+
     void main()
     {
+        int base = (firstInstance + gl_InstanceID) * 8;
+        mat4 model = mat4(texelFetch(objectData, base), texelFetch(objectData, base + 1),
+                          texelFetch(objectData, base + 2), texelFetch(objectData, base + 3));
+        vec4 n0 = texelFetch(objectData, base + 4);
+        vec4 n1 = texelFetch(objectData, base + 5);
+        vec4 n2 = texelFetch(objectData, base + 6);
+
         FragPos = vec3(model * vec4(aPos, 1.0));
-        Normal = mat3(transpose(inverse(model))) * aNormal;
+        Normal = mat3(n0.xyz, n1.xyz, n2.xyz) * aNormal;
         TexCoord = aTexCoord;
+        ObjectColor = texelFetch(objectData, base + 7).rgb;
+        TextureLayer = n0.w;
         gl_Position = projection * view * vec4(FragPos, 1.0);
     }
 )";
 
-// Fragment Shader source code with lighting and textures
-const char *fragmentShaderSource = R"(
+// Lighting shared by the sphere programs: the tessellated mesh and the ray-cast
+// impostor. Each program's fragment main() is appended to this.
+const char *sphereShadingSource = R"(
     #version 330 core
     out vec4 FragColor;
-    
+
+    flat in vec3 ObjectColor;
+    flat in float TextureLayer;
+
+    layout (std140) uniform FrameData
+    {
+        mat4 view;
+        mat4 projection;
+        vec4 lightPos;
+        vec4 lightColor;
+        vec4 viewPos;
+    };
+
+    uniform sampler2DArray diffuseTextures;
+
+    vec4 shadeSphere(vec3 FragPos, vec3 Normal, vec3 baseColor)
+    {
+        // Stars glow on their own; planets are lit by the sun
+#ifdef EMISSIVE
+        // Enhanced sun rendering with glow and corona effects
+        
+        // Calculate distance from center for corona effect; the sun is the light
+        vec3 center = lightPos.xyz;
+        float distFromCenter = length(FragPos - center);
+        float corona = 1.0 - smoothstep(0.8, 1.2, distFromCenter);
+        
+        // Add texture detail to the sun surface
+        vec3 sunSurface = baseColor;
+        
+        // Create corona glow effect
+        vec3 coronaColor = vec3(1.0, 0.8, 0.4) * corona * 0.5;
+        
+        // Add rim lighting for depth
+        vec3 viewDir = normalize(viewPos.xyz - FragPos);
+        float rim = 1.0 - max(dot(normalize(Normal), viewDir), 0.0);
+        rim = pow(rim, 3.0);
+        
+        // Combine all effects
+        vec3 finalColor = sunSurface + coronaColor + rim * vec3(1.0, 0.7, 0.3) * 0.3;
+        
+        // Make sun glow brighter
+        finalColor *= 2.5;
+        
+        return vec4(finalColor, 1.0);
+#else
+        // Normal lighting for planets
+        
+        // Ambient lighting - planets in shadow should still be visible
+        float ambientStrength = 0.2;
+        vec3 ambient = ambientStrength * lightColor.rgb;
+        
+        // Diffuse lighting
+        vec3 norm = normalize(Normal);
+        vec3 lightDir = normalize(lightPos.xyz - FragPos);
+        float diff = max(dot(norm, lightDir), 0.0);
+        vec3 diffuse = diff * lightColor.rgb;
+        
+        // Specular lighting
+        float specularStrength = 0.3;
+        vec3 viewDir = normalize(viewPos.xyz - FragPos);
+        vec3 reflectDir = reflect(-lightDir, norm);
+        float spec = pow(max(dot(viewDir, reflectDir), 0.0), 16);
+        vec3 specular = specularStrength * spec * lightColor.rgb;
+        
+        // Distance attenuation - planets farther from sun get less light
+        float distance = length(lightPos.xyz - FragPos);
+        float attenuation = 1.0 / (1.0 + 0.01 * distance + 0.0001 * distance * distance);
+        
+        vec3 result = (ambient + (diffuse + specular) * attenuation) * baseColor;
+        return vec4(result, 1.0);
+#endif
+    }
+)";
+
+// Fragment Shader source code with lighting and textures
+const char *fragmentShaderSource = R"(
     in vec3 FragPos;
     in vec3 Normal;
     in vec2 TexCoord;
-    
-    uniform vec3 lightPos;
-    uniform vec3 lightColor;
-    uniform vec3 objectColor;
-    uniform vec3 viewPos;
-    uniform sampler2D diffuseTexture;
-    uniform bool useTexture;
-    
+
     void main()
     {
         // Get base color from texture or object color
-        vec3 baseColor;
-        if (useTexture) {
-            baseColor = texture(diffuseTexture, TexCoord).rgb;
-        } else {
-            baseColor = objectColor;
+#ifdef TEXTURED
+        vec3 baseColor = texture(diffuseTextures, vec3(TexCoord, TextureLayer)).rgb;
+#else
+        vec3 baseColor = ObjectColor;
+#endif
+
+        FragColor = shadeSphere(FragPos, Normal, baseColor);
+    }
+)";
+
+// Ray-cast sphere impostors: each body is a camera-facing quad just big enough
+// to cover its silhouette, and the fragment shader intersects the view ray with
+// the exact sphere for position, depth, normal and texture coordinates
+const char *rayCastVertexShaderSource = R"(
+    #version 330 core
+
+    layout (std140) uniform FrameData
+    {
+        mat4 view;
+        mat4 projection;
+        vec4 lightPos;
+        vec4 lightColor;
+        vec4 viewPos;
+    };
+
+    uniform samplerBuffer objectData;
+    uniform int firstInstance;
+
+    out vec3 EyeRay;
+    flat out vec3 EyeCenter;
+    flat out float Radius;
+    flat out mat3 NormalMatrix;
+    flat out vec3 ObjectColor;
+    flat out float TextureLayer;
+
+    void main()
+    {
+        int base = (firstInstance + gl_InstanceID) * 8;
+        vec3 center = texelFetch(objectData, base + 3).xyz;
+        Radius = length(texelFetch(objectData, base + 1).xyz);
+        vec4 n0 = texelFetch(objectData, base + 4);
+        vec4 n1 = texelFetch(objectData, base + 5);
+        vec4 n2 = texelFetch(objectData, base + 6);
+        NormalMatrix = mat3(n0.xyz, n1.xyz, n2.xyz);
+        ObjectColor = texelFetch(objectData, base + 7).rgb;
+        TextureLayer = n0.w;
+
+        // The camera sits at the eye-space origin. A quad through the centre,
+        // facing the camera, covers the silhouette cone when its half-size is
+        // r d / sqrt(d^2 - r^2).
+        EyeCenter = vec3(view * vec4(center, 1.0));
+        float d2 = dot(EyeCenter, EyeCenter);
+        float r2 = Radius * Radius;
+        if (d2 <= r2 * 1.0001) {
+            // Camera inside the sphere: nothing to draw
+            gl_Position = vec4(0.0, 0.0, 0.0, 1.0);
+            EyeRay = vec3(0.0);
+            return;
         }
-        
-        // Check if this is the sun (bright yellow/orange color)
-        bool isSun = (baseColor.r > 0.8 && baseColor.g > 0.8 && baseColor.b < 0.3);
-        
-        if (isSun) {
-            // Enhanced sun rendering with glow and corona effects
-            
-            // Calculate distance from center for corona effect
-            vec3 center = vec3(0.0, 0.0, 0.0);
-            float distFromCenter = length(FragPos - center);
-            float corona = 1.0 - smoothstep(0.8, 1.2, distFromCenter);
-            
-            // Add texture detail to the sun surface
-            vec3 sunSurface = baseColor;
-            
-            // Create corona glow effect
-            vec3 coronaColor = vec3(1.0, 0.8, 0.4) * corona * 0.5;
-            
-            // Add rim lighting for depth
-            vec3 viewDir = normalize(viewPos - FragPos);
-            float rim = 1.0 - max(dot(normalize(Normal), viewDir), 0.0);
-            rim = pow(rim, 3.0);
-            
-            // Combine all effects
-            vec3 finalColor = sunSurface + coronaColor + rim * vec3(1.0, 0.7, 0.3) * 0.3;
-            
-            // Make sun glow brighter
-            finalColor *= 2.5;
-            
-            FragColor = vec4(finalColor, 1.0);
-        } else {
-            // Normal lighting for planets
-            
-            // Ambient lighting - planets in shadow should still be visible
-            float ambientStrength = 0.2;
-            vec3 ambient = ambientStrength * lightColor;
-            
-            // Diffuse lighting
-            vec3 norm = normalize(Normal);
-            vec3 lightDir = normalize(lightPos - FragPos);
-            float diff = max(dot(norm, lightDir), 0.0);
-            vec3 diffuse = diff * lightColor;
-            
-            // Specular lighting
-            float specularStrength = 0.3;
-            vec3 viewDir = normalize(viewPos - FragPos);
-            vec3 reflectDir = reflect(-lightDir, norm);
-            float spec = pow(max(dot(viewDir, reflectDir), 0.0), 16);
-            vec3 specular = specularStrength * spec * lightColor;
-            
-            // Distance attenuation - planets farther from sun get less light
-            float distance = length(lightPos - FragPos);
-            float attenuation = 1.0 / (1.0 + 0.01 * distance + 0.0001 * distance * distance);
-            
-            vec3 result = (ambient + (diffuse + specular) * attenuation) * baseColor;
-            FragColor = vec4(result, 1.0);
+        float halfSize = Radius * sqrt(d2 / (d2 - r2));
+
+        vec3 forward = EyeCenter / sqrt(d2);
+        vec3 right = normalize(abs(forward.y) < 0.99 ? cross(forward, vec3(0.0, 1.0, 0.0)) : cross(forward, vec3(1.0, 0.0, 0.0)));
+        vec3 up = cross(right, forward);
+
+        vec2 corner = vec2(float(gl_VertexID & 1), float(gl_VertexID >> 1)) * 2.0 - 1.0;
+        EyeRay = EyeCenter + (corner.x * right + corner.y * up) * halfSize;
+        gl_Position = projection * vec4(EyeRay, 1.0);
+    }
+)";
+
+const char *rayCastFragmentShaderSource = R"(
+    in vec3 EyeRay;
+    flat in vec3 EyeCenter;
+    flat in float Radius;
+    flat in mat3 NormalMatrix;
+
+    const float pi = 3.14159265358979;
+
+    void main()
+    {
+        // Nearest intersection of the ray from the eye with the sphere
+        vec3 dir = normalize(EyeRay);
+        float b = dot(dir, EyeCenter);
+        float h = b * b - (dot(EyeCenter, EyeCenter) - Radius * Radius);
+        if (h < 0.0)
+            discard;
+        vec3 eyeHit = dir * (b - sqrt(h));
+
+        vec4 clip = projection * vec4(eyeHit, 1.0);
+        gl_FragDepth = (clip.z / clip.w) * (gl_DepthRange.far - gl_DepthRange.near) * 0.5 +
+                       (gl_DepthRange.far + gl_DepthRange.near) * 0.5;
+
+        // The view matrix is a pure rotation, so its transpose takes eye space back to render space
+        mat3 eyeToWorld = transpose(mat3(view));
+        vec3 fragPos = eyeToWorld * eyeHit;
+        vec3 normal = eyeToWorld * ((eyeHit - EyeCenter) / Radius);
+
+#ifdef TEXTURED
+        // Back to the unit sphere the mesh is built from; the normal matrix of
+        // a uniformly scaled rotation is that rotation over the scale, so its
+        // transpose undoes the rotation
+        vec3 local = normalize(transpose(NormalMatrix) * normal);
+
+        // Same equirectangular mapping as createSphereVertices: s follows
+        // the angle around z, t runs from +z down to -z
+        float s = atan(local.y, local.x) / (2.0 * pi);
+        float t = acos(clamp(local.z, -1.0, 1.0)) / pi;
+        vec2 uv = vec2(fract(s), t);
+
+        // Take derivatives across the seam from a copy that wraps elsewhere
+        vec2 wrapped = vec2(fract(s + 0.5) - 0.5, t);
+        vec2 dx = dFdx(uv), dy = dFdy(uv);
+        vec2 dxWrapped = dFdx(wrapped), dyWrapped = dFdy(wrapped);
+        if (abs(dxWrapped.x) + abs(dyWrapped.x) < abs(dx.x) + abs(dy.x)) {
+            dx = dxWrapped;
+            dy = dyWrapped;
         }
+        vec3 baseColor = textureGrad(diffuseTextures, vec3(uv, TextureLayer), dx, dy).rgb;
+#else
+        vec3 baseColor = ObjectColor;
+#endif
+
+        FragColor = shadeSphere(fragPos, normal, baseColor);
+    }
+)";
+
+// Point-sprite impostors for bodies only a few pixels across: one lit disc per body
+const char *impostorVertexShaderSource = R"(
+    #version 330 core
+
+    layout (std140) uniform FrameData
+    {
+        mat4 view;
+        mat4 projection;
+        vec4 lightPos;
+        vec4 lightColor;
+        vec4 viewPos;
+    };
+
+    uniform samplerBuffer objectData;
+    uniform int firstInstance;
+
+    // Pixels per unit of radius at unit distance
+    uniform float pixelScale;
+
+    flat out vec3 ObjectColor;
+    flat out vec3 LightDir;
+    flat out float Attenuation;
+
+    void main()
+    {
+        int base = (firstInstance + gl_InstanceID) * 8;
+        vec3 center = texelFetch(objectData, base + 3).xyz;
+        float radius = length(texelFetch(objectData, base + 1).xyz);
+
+        vec4 eye = view * vec4(center, 1.0);
+        gl_Position = projection * eye;
+        gl_PointSize = max(2.0 * radius * pixelScale / max(-eye.z, 1e-3), 1.0);
+
+        ObjectColor = texelFetch(objectData, base + 7).rgb;
+
+        // The sprite faces the viewer, so light it in eye space
+        LightDir = normalize(mat3(view) * (lightPos.xyz - center));
+        float distance = length(lightPos.xyz - center);
+        Attenuation = 1.0 / (1.0 + 0.01 * distance + 0.0001 * distance * distance);
+    }
+)";
+
+const char *impostorFragmentShaderSource = R"(
+    #version 330 core
+    out vec4 FragColor;
+
+    flat in vec3 ObjectColor;
+    flat in vec3 LightDir;
+    flat in float Attenuation;
+
+    void main()
+    {
+        // Sphere normal under this point of the sprite; point coordinates run top-down
+        vec2 p = gl_PointCoord * 2.0 - 1.0;
+        float r2 = dot(p, p);
+        if (r2 > 1.0)
+            discard;
+        vec3 normal = vec3(p.x, -p.y, sqrt(1.0 - r2));
+
+        // Same lighting terms as the sphere shader
+#ifdef EMISSIVE
+        FragColor = vec4(ObjectColor * 2.5, 1.0);
+#else
+        float diff = max(dot(normal, LightDir), 0.0);
+        FragColor = vec4((0.2 + diff * Attenuation) * ObjectColor, 1.0);
+#endif
+    }
+)";
+
+// Point shaders for the star cluster
+const char *pointVertexShaderSource = R"(
+    #version 330 core
+    layout (location = 0) in vec3 aPos;
+
+    layout (std140) uniform FrameData
+    {
+        mat4 view;
+        mat4 projection;
+        vec4 lightPos;
+        vec4 lightColor;
+        vec4 viewPos;
+    };
+
+    uniform mat4 model;
+
+    void main()
+    {
+        gl_Position = projection * view * model * vec4(aPos, 1.0);
+    }
+)";
+
+const char *pointFragmentShaderSource = R"(
+    #version 330 core
+    out vec4 FragColor;
+
+    uniform vec3 color;
+
+    void main()
+    {
+        FragColor = vec4(color, 1.0);
+    }
+)";
+
+// Billboard shaders for the asteroid and Kuiper belts: one camera-facing quad
+// per instance, with positions streamed as separate x, y and z arrays
+const char *beltVertexShaderSource = R"(
+    #version 330 core
+    layout (location = 0) in vec2 aCorner;
+    layout (location = 1) in float aX;
+    layout (location = 2) in float aY;
+    layout (location = 3) in float aZ;
+    layout (location = 4) in vec4 aColor;
+
+    out vec2 Corner;
+    out vec3 Color;
+
+    layout (std140) uniform FrameData
+    {
+        mat4 view;
+        mat4 projection;
+        vec4 lightPos;
+        vec4 lightColor;
+        vec4 viewPos;
+    };
+
+    uniform mat4 model;
+    uniform float particleSize;
+
+    void main()
+    {
+        vec4 centre = view * model * vec4(aX, aY, aZ, 1.0);
+        centre.xy += aCorner * particleSize;
+        gl_Position = projection * centre;
+        Corner = aCorner;
+        Color = aColor.rgb;
+    }
+)";
+
+const char *beltFragmentShaderSource = R"(
+    #version 330 core
+    in vec2 Corner;
+    in vec3 Color;
+    out vec4 FragColor;
+
+    void main()
+    {
+        // Round the quad off into a disc
+        if (dot(Corner, Corner) > 1.0)
+            discard;
+        FragColor = vec4(Color, 1.0);
     }
 )";
 
-// Camera class for 3D navigation
+// Camera class for 3D navigation. The position is double precision and never
+// reaches the GPU: the view matrix is rotation only, and every object is
+// placed relative to the camera on the CPU (see BodyStore::rebase)
 class Camera
 {
 public:
-    glm::vec3 position;
+    glm::dvec3 position;
     glm::vec3 front;
     glm::vec3 up;
     float yaw;
@@ -329,7 +528,7 @@ public:
 
     glm::mat4 getViewMatrix()
     {
-        return glm::lookAt(position, position + front, up);
+        return glm::lookAt(glm::vec3(0.0f), front, up);
     }
 
     void updateCameraVectors()
@@ -342,91 +541,61 @@ public:
     }
 };
 
-// Celestial body class
+// Per-body render data; the kinematic state lives in the BodyStore
 class CelestialBody
 {
 public:
     std::string name;
-    float radius;
-    float distanceFromParent;
-    float orbitalPeriod;
-    float rotationPeriod;
-    float orbitalAngle;
-    float rotationAngle;
     glm::vec3 color;
-    CelestialBody *parent;
-    std::vector<CelestialBody *> children;
-    unsigned int textureID;
+    int bodyIndex;
+    TextureSlot texture;
     bool useTexture;
 
-    CelestialBody(const std::string &n, float r, float dist, float orbPeriod,
-                  float rotPeriod, const glm::vec3 &c, CelestialBody *p = nullptr, float initialOrbitalAngle = 0.0f)
-        : name(n), radius(r), distanceFromParent(dist), orbitalPeriod(orbPeriod),
-          rotationPeriod(rotPeriod), orbitalAngle(initialOrbitalAngle), rotationAngle(0.0f),
-          color(c), parent(p), useTexture(true), textureID(0)
-    {
-        if (parent)
-        {
-            parent->children.push_back(this);
-        }
-    }
-
-    void initializeTexture()
-    {
-        textureID = createProceduralTexture(name);
-    }
+    // Glows instead of being lit: the sun
+    bool emissive;
 
-    void update(float deltaTime)
+    CelestialBody(const std::string &n, const glm::vec3 &c, int index)
+        : name(n), color(c), bodyIndex(index), useTexture(true), emissive(false)
     {
-        // Update orbital position - planets with longer periods move slower
-        if (orbitalPeriod > 0)
-        {
-            orbitalAngle += (360.0f / orbitalPeriod) * deltaTime * 0.5f; // Reduced scale factor for slower motion
-        }
-
-        // Update rotation
-        if (rotationPeriod > 0)
-        {
-            rotationAngle += (360.0f / rotationPeriod) * deltaTime * 0.5f; // Reduced scale factor for slower motion
-        }
-
-        // Update children
-        for (auto child : children)
-        {
-            child->update(deltaTime);
-        }
-    }
-
-    glm::mat4 getModelMatrix()
-    {
-        glm::mat4 model = glm::mat4(1.0f);
-
-        // Apply parent's transformation
-        if (parent)
-        {
-            model = parent->getModelMatrix();
-        }
-
-        // Correct order: rotate first, then translate
-        if (distanceFromParent > 0)
-        {
-            model = glm::rotate(model, glm::radians(orbitalAngle), glm::vec3(0.0f, 1.0f, 0.0f));
-            model = glm::translate(model, glm::vec3(distanceFromParent, 0.0f, 0.0f));
-        }
-
-        // Rotation transformation
-        model = glm::rotate(model, glm::radians(rotationAngle), glm::vec3(0.0f, 1.0f, 0.0f));
-
-        // Scale to radius
-        model = glm::scale(model, glm::vec3(radius));
-
-        return model;
     }
 };
 
 // Global variables
 Camera camera;
-std::vector<CelestialBody *> solarSystem;
+BodyStore bodies;
+ThreadPool threadPool;
+UpdateScheduler scheduler(threadPool);
+std::vector<CelestialBody> solarSystem;
+
+// Optional self-gravitating star cluster, toggled with 'G'
+const std::size_t clusterParticleCount = 10000;
+ParticleSystem cluster;
+BarnesHutSolver clusterTreeSolver(threadPool);
+FmmSolver clusterFmmSolver(threadPool);
+DirectSolver clusterDirectSolver(threadPool);
+FixedStepIntegrator clusterIntegrator(clusterTreeSolver);
+double clusterInitialEnergy = 0.0;
+int clusterSteps = 0;
+bool clusterEnabled = false;
+bool clusterKeyDown = false;
+bool integratorKeyDown = false;
+bool solverKeyDown = false;
+
+// Asteroid and Kuiper belts of massless particles around the sun, toggled with 'K'
+const std::size_t asteroidBeltCount = 1000000;
+const std::size_t kuiperBeltCount = 1000000;
+BeltParticles belts;
+bool beltsEnabled = true;
+bool beltKeyDown = false;
+
+// Draw bodies as tessellated meshes or as ray-cast sphere impostors, toggled with 'M'
+bool rayCastSpheres = false;
+bool rayCastKeyDown = false;
+
+// Size of the framebuffer being drawn to
+int viewportWidth = 1200;
+int viewportHeight = 800;
+
 float lastX = 400.0f;
 float lastY = 300.0f;
 bool firstMouse = true;
@@ -442,6 +611,8 @@ void errorCallback(int error, const char *description)
 void framebufferSizeCallback(GLFWwindow *window, int width, int height)
 {
     glViewport(0, 0, width, height);
+    viewportWidth = width;
+    viewportHeight = height;
 }
 
 // Mouse callback
@@ -513,7 +684,7 @@ void processInput(GLFWwindow *window)
     // Reset view with 'R' key
     if (glfwGetKey(window, GLFW_KEY_R) == GLFW_PRESS)
     {
-        camera.position = glm::vec3(0.0f, 15.0f, 30.0f); // Good overview position
+        camera.position = glm::dvec3(0.0, 15.0, 30.0); // Good overview position
         camera.yaw = -90.0f;
         camera.pitch = -20.0f; // Look down slightly
         camera.fov = 45.0f;
@@ -540,6 +711,71 @@ void processInput(GLFWwindow *window)
     if (glfwGetKey(window, GLFW_KEY_LEFT_SHIFT) == GLFW_PRESS)
         camera.position -= cameraSpeed * camera.up;
 
+    // Scrub simulation time; seeking is closed-form, so any jump costs the same
+    const double scrubStep = 5.0;
+    if (glfwGetKey(window, GLFW_KEY_RIGHT_BRACKET) == GLFW_PRESS)
+        bodies.seek(bodies.simulationTime + scrubStep);
+    if (glfwGetKey(window, GLFW_KEY_LEFT_BRACKET) == GLFW_PRESS)
+        bodies.seek(bodies.simulationTime - scrubStep);
+
+    // Toggle the star cluster; the first time it is shown it is created and its forces primed
+    bool clusterKey = glfwGetKey(window, GLFW_KEY_G) == GLFW_PRESS;
+    if (clusterKey && !clusterKeyDown)
+    {
+        clusterEnabled = !clusterEnabled;
+        if (clusterEnabled && cluster.size() == 0)
+        {
+            GravitySolver &solver = clusterIntegrator.forceSolver();
+            createPlummerSphere(cluster, clusterParticleCount, 1.0, 1.0, solver.gravitationalConstant, 1);
+            solver.computeForces(cluster);
+            clusterInitialEnergy = clusterIntegrator.energy(cluster);
+        }
+    }
+    clusterKeyDown = clusterKey;
+
+    // Toggle the asteroid and Kuiper belts
+    bool beltKey = glfwGetKey(window, GLFW_KEY_K) == GLFW_PRESS;
+    if (beltKey && !beltKeyDown)
+    {
+        beltsEnabled = !beltsEnabled;
+    }
+    beltKeyDown = beltKey;
+
+    // Switch between sphere meshes and ray-cast impostors
+    bool rayCastKey = glfwGetKey(window, GLFW_KEY_M) == GLFW_PRESS;
+    if (rayCastKey && !rayCastKeyDown)
+    {
+        rayCastSpheres = !rayCastSpheres;
+        std::cout << "Spheres: " << (rayCastSpheres ? "ray-cast impostors" : "tessellated meshes") << std::endl;
+    }
+    rayCastKeyDown = rayCastKey;
+
+    // Switch the cluster's integrator between leapfrog and Yoshida 4. Wisdom-Holman
+    // is left out: a star cluster has no central mass, so it would be leapfrog again.
+    bool integratorKey = glfwGetKey(window, GLFW_KEY_I) == GLFW_PRESS;
+    if (integratorKey && !integratorKeyDown)
+    {
+        clusterIntegrator.method = clusterIntegrator.method == IntegratorMethod::Leapfrog ? IntegratorMethod::Yoshida4
+                                                                                          : IntegratorMethod::Leapfrog;
+        std::cout << "Cluster integrator: " << integratorName(clusterIntegrator.method) << std::endl;
+    }
+    integratorKeyDown = integratorKey;
+
+    // Cycle the cluster's force backend: Barnes-Hut tree, FMM, exact direct summation
+    bool solverKey = glfwGetKey(window, GLFW_KEY_B) == GLFW_PRESS;
+    if (solverKey && !solverKeyDown)
+    {
+        GravitySolver *current = &clusterIntegrator.forceSolver();
+        if (current == &clusterTreeSolver)
+            clusterIntegrator.setSolver(clusterFmmSolver);
+        else if (current == &clusterFmmSolver)
+            clusterIntegrator.setSolver(clusterDirectSolver);
+        else
+            clusterIntegrator.setSolver(clusterTreeSolver);
+        std::cout << "Cluster forces: " << clusterIntegrator.forceSolver().name() << std::endl;
+    }
+    solverKeyDown = solverKey;
+
     // Fast movement for long distances
     if (glfwGetKey(window, GLFW_KEY_LEFT_CONTROL) == GLFW_PRESS)
     {
@@ -547,78 +783,63 @@ void processInput(GLFWwindow *window)
     }
 }
 
-// Function to create sphere vertices with texture coordinates
-std::vector<float> createSphereVertices(float radius, int sectors, int stacks)
+// Draw sun with larger scale for better visibility
+float drawScale(const CelestialBody &body)
 {
-    std::vector<float> vertices;
-
-    for (int i = 0; i <= stacks; ++i)
-    {
-        float stackAngle = M_PI / 2 - i * M_PI / stacks;
-        float xy = radius * cosf(stackAngle);
-        float z = radius * sinf(stackAngle);
+    return body.name == "Sun" ? 1.2f : 1.0f;
+}
 
-        for (int j = 0; j <= sectors; ++j)
-        {
-            float sectorAngle = j * 2 * M_PI / sectors;
-
-            float x = xy * cosf(sectorAngle);
-            float y = xy * sinf(sectorAngle);
-
-            // Position
-            vertices.push_back(x);
-            vertices.push_back(y);
-            vertices.push_back(z);
-
-            // Normal
-            vertices.push_back(x / radius);
-            vertices.push_back(y / radius);
-            vertices.push_back(z / radius);
-
-            // Texture coordinates
-            float s = (float)j / sectors;
-            float t = (float)i / stacks;
-            vertices.push_back(s);
-            vertices.push_back(t);
-        }
-    }
+// Program variant a body is drawn with
+unsigned sphereFeatures(const CelestialBody &body)
+{
+    return (body.useTexture ? SphereTextured : 0u) | (body.emissive ? SphereEmissive : 0u);
+}
 
-    return vertices;
+// Add a body to the simulation store and its render data to the solar system
+int addCelestialBody(const std::string &name, float radius, float dist, float orbPeriod, float rotPeriod,
+                     const glm::vec3 &color, int parent = BodyStore::NoParent, float initialOrbitalAngle = 0.0f)
+{
+    int index = bodies.addBody(radius, dist, orbPeriod, rotPeriod, parent, initialOrbitalAngle);
+    solarSystem.emplace_back(name, color, index);
+    return index;
 }
 
-// Function to create sphere indices
-std::vector<unsigned int> createSphereIndices(int sectors, int stacks)
+// Add a body on an elliptical Kepler orbit
+int addCelestialBody(const std::string &name, float radius, const OrbitalElements &elements, float rotPeriod,
+                     const glm::vec3 &color, int parent = BodyStore::NoParent)
 {
-    std::vector<unsigned int> indices;
+    int index = bodies.addKeplerBody(radius, elements, rotPeriod, parent);
+    solarSystem.emplace_back(name, color, index);
+    return index;
+}
 
-    for (int i = 0; i < stacks; ++i)
+int main(int argc, char **argv)
+{
+    HeadlessOptions headless;
+    if (!parseHeadlessOptions(argc, argv, headless))
     {
-        int k1 = i * (sectors + 1);
-        int k2 = k1 + sectors + 1;
+        return -1;
+    }
 
-        for (int j = 0; j < sectors; ++j, ++k1, ++k2)
+    // Make the dump directory up front, so a run that cannot save its frames fails before rendering any
+    if (headless.enabled && !headless.dumpDirectory.empty())
+    {
+        std::error_code error;
+        std::filesystem::create_directories(headless.dumpDirectory, error);
+        if (error)
         {
-            if (i != 0)
-            {
-                indices.push_back(k1);
-                indices.push_back(k2);
-                indices.push_back(k1 + 1);
-            }
-
-            if (i != (stacks - 1))
-            {
-                indices.push_back(k1 + 1);
-                indices.push_back(k2);
-                indices.push_back(k2 + 1);
-            }
+            std::cerr << "Could not create " << headless.dumpDirectory << ": " << error.message() << std::endl;
+            return -1;
         }
     }
 
-    return indices;
-}
+    // Headless runs need no display: GLFW's null platform supplies the timer and
+    // a window-less context, and frames go to an offscreen framebuffer
+    if (headless.enabled)
+    {
+        glfwInitHint(GLFW_PLATFORM, GLFW_PLATFORM_NULL);
+    }
 
-int main()
-{
     // Initialize GLFW
     if (!glfwInit())
     {
@@ -638,8 +859,18 @@ int main()
     glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
 #endif
 
+    // Surfaceless EGL or OSMesa; Mesa's llvmpipe renders either on the CPU
+    if (headless.enabled)
+    {
+        glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+        glfwWindowHint(GLFW_CONTEXT_CREATION_API, headless.osmesa ? GLFW_OSMESA_CONTEXT_API : GLFW_EGL_CONTEXT_API);
+        viewportWidth = headless.width;
+        viewportHeight = headless.height;
+        rayCastSpheres = headless.rayCast;
+    }
+
     // Create window
-    GLFWwindow *window = glfwCreateWindow(1200, 800, "Solar System Simulation", NULL, NULL);
+    GLFWwindow *window = glfwCreateWindow(viewportWidth, viewportHeight, "Solar System Simulation", NULL, NULL);
     if (!window)
     {
         std::cerr << "Failed to create GLFW window" << std::endl;
@@ -668,61 +899,124 @@ int main()
     glEnable(GL_DEPTH_TEST);
 
     // Set initial viewport
-    glViewport(0, 0, 1200, 800);
-
-    // Build and compile our shader program
-    // Vertex shader
-    unsigned int vertexShader = glCreateShader(GL_VERTEX_SHADER);
-    glShaderSource(vertexShader, 1, &vertexShaderSource, NULL);
-    glCompileShader(vertexShader);
+    glViewport(0, 0, viewportWidth, viewportHeight);
 
-    // Check for vertex shader compile errors
-    int success;
-    char infoLog[512];
-    glGetShaderiv(vertexShader, GL_COMPILE_STATUS, &success);
-    if (!success)
+    // Without a window surface everything is drawn into a framebuffer object
+    std::unique_ptr<OffscreenTarget> offscreen;
+    if (headless.enabled)
     {
-        glGetShaderInfoLog(vertexShader, 512, NULL, infoLog);
-        std::cerr << "ERROR::SHADER::VERTEX::COMPILATION_FAILED\n"
-                  << infoLog << std::endl;
+        offscreen.reset(new OffscreenTarget(headless.width, headless.height));
+        if (!offscreen->complete())
+        {
+            std::cerr << "Failed to create a " << headless.width << "x" << headless.height << " offscreen framebuffer" << std::endl;
+            glfwTerminate();
+            return -1;
+        }
+        offscreen->bind();
+        std::cout << "Headless: " << glGetString(GL_RENDERER) << ", " << headless.width << "x" << headless.height
+                  << ", " << headless.frames << " frames" << std::endl;
     }
 
-    // Fragment shader
-    unsigned int fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
-    glShaderSource(fragmentShader, 1, &fragmentShaderSource, NULL);
-    glCompileShader(fragmentShader);
+    // Create solar system with realistic relative scales and orbital periods.
+    // Planet orbits use real eccentricities and orientations as Kepler elements
+    // {a, e, i, node, periapsis, mean anomaly at epoch, period}, with the mean
+    // anomaly chosen so each planet starts at its usual angle.
+    // Sun
+    int sun = addCelestialBody("Sun", 2.0f, 0.0f, 0.0f, 27.0f, glm::vec3(1.0f, 1.0f, 0.0f));
+    solarSystem.back().emissive = true;
 
-    // Check for fragment shader compile errors
-    glGetShaderiv(fragmentShader, GL_COMPILE_STATUS, &success);
-    if (!success)
-    {
-        glGetShaderInfoLog(fragmentShader, 512, NULL, infoLog);
-        std::cerr << "ERROR::SHADER::FRAGMENT::COMPILATION_FAILED\n"
-                  << infoLog << std::endl;
-    }
+    // Mercury - smallest planet, fastest and most eccentric orbit (scaled down for visibility)
+    addCelestialBody("Mercury", 0.08f, {4.0, 0.2056, 7.005, 48.331, 29.124, -77.456, 10.0}, 58.6f, glm::vec3(0.7f, 0.7f, 0.7f), sun);
 
-    // Link shaders
-    unsigned int shaderProgram = glCreateProgram();
-    glAttachShader(shaderProgram, vertexShader);
-    glAttachShader(shaderProgram, fragmentShader);
-    glLinkProgram(shaderProgram);
+    // Venus - similar size to Earth, slow rotation
+    addCelestialBody("Venus", 0.15f, {6.0, 0.0068, 3.395, 76.680, 54.884, -86.564, 25.0}, -243.0f, glm::vec3(1.0f, 0.8f, 0.6f), sun);
 
-    // Check for linking errors
-    glGetProgramiv(shaderProgram, GL_LINK_STATUS, &success);
-    if (!success)
+    // Earth - our home planet
+    addCelestialBody("Earth", 0.16f, {8.0, 0.0167, 0.0, 0.0, 102.937, -12.937, 40.0}, 1.0f, glm::vec3(0.2f, 0.5f, 1.0f), sun);
+
+    // Mars - smaller than Earth
+    addCelestialBody("Mars", 0.12f, {10.0, 0.0934, 1.850, 49.558, 286.502, -201.060, 75.0}, 1.03f, glm::vec3(1.0f, 0.3f, 0.2f), sun);
+
+    // Jupiter - largest planet, gas giant
+    addCelestialBody("Jupiter", 0.45f, {14.0, 0.0489, 1.303, 100.464, 273.867, -194.331, 200.0}, 0.41f, glm::vec3(0.9f, 0.7f, 0.5f), sun);
+
+    // Saturn - second largest, with rings (we'll add rings later)
+    addCelestialBody("Saturn", 0.38f, {18.0, 0.0565, 2.485, 113.665, 339.392, -228.057, 500.0}, 0.45f, glm::vec3(0.9f, 0.8f, 0.6f), sun);
+
+    // Uranus - ice giant, tilted on its side
+    addCelestialBody("Uranus", 0.27f, {22.0, 0.0457, 0.773, 74.006, 96.998, 98.996, 1000.0}, -0.72f, glm::vec3(0.6f, 0.8f, 0.9f), sun);
+
+    // Neptune - farthest planet, similar to Uranus
+    addCelestialBody("Neptune", 0.26f, {26.0, 0.0113, 1.770, 131.784, 273.187, -89.971, 2000.0}, 0.67f, glm::vec3(0.3f, 0.5f, 0.9f), sun);
+
+    // Body textures are generated on the worker threads while shaders compile and
+    // geometry is built here; only the upload has to wait for them. Generated
+    // textures are kept on disk, so later runs map them instead.
+    TextureCache textureCache("texture_cache");
+    ProceduralTextureQueue textureQueue(threadPool, bodyTextureSize, &textureCache);
+    for (const auto &body : solarSystem)
     {
-        glGetProgramInfoLog(shaderProgram, 512, NULL, infoLog);
-        std::cerr << "ERROR::SHADER::PROGRAM::LINKING_FAILED\n"
-                  << infoLog << std::endl;
+        textureQueue.add(body.name);
     }
 
-    // Delete shaders as they're linked into our program now and no longer necessary
-    glDeleteShader(vertexShader);
-    glDeleteShader(fragmentShader);
+    // Build and compile our shader programs, then resolve every uniform once.
+    // Linked programs are kept on disk, so later runs load them instead.
+    double shaderStart = glfwGetTime();
+    ProgramBinaryCache programCache("shader_cache", (GLADloadproc)glfwGetProcAddress);
+
+    // Sphere programs come in one variant per material, so no shader branches on
+    // what it is drawing; compile them all up front rather than on first sight
+    std::string meshFragmentSource = std::string(sphereShadingSource) + fragmentShaderSource;
+    std::string rayCastFragmentSource = std::string(sphereShadingSource) + rayCastFragmentShaderSource;
+    ShaderVariantCache<SphereBindings> meshVariants(vertexShaderSource, meshFragmentSource.c_str(),
+                                                    sphereFeatureNames, sphereFeatureCount, &programCache);
+    ShaderVariantCache<SphereBindings> rayCastVariants(rayCastVertexShaderSource, rayCastFragmentSource.c_str(),
+                                                       sphereFeatureNames, sphereFeatureCount, &programCache);
+    ShaderVariantCache<SphereBindings> impostorVariants(impostorVertexShaderSource, impostorFragmentShaderSource,
+                                                        sphereFeatureNames, sphereFeatureCount, &programCache);
+    for (unsigned features = 0; features < sphereVariantCount; features++)
+    {
+        meshVariants.get(features);
+        rayCastVariants.get(features);
+        impostorVariants.get(features & SphereEmissive);
+    }
 
-    // Create sphere geometry
-    auto sphereVertices = createSphereVertices(1.0f, 30, 30);
-    auto sphereIndices = createSphereIndices(30, 30);
+    ShaderProgram pointProgram(pointVertexShaderSource, pointFragmentShaderSource, &programCache);
+    Uniform<glm::mat4> pointModel = pointProgram.uniform<glm::mat4>("model");
+    Uniform<glm::vec3> pointColor = pointProgram.uniform<glm::vec3>("color");
+
+    ShaderProgram beltProgram(beltVertexShaderSource, beltFragmentShaderSource, &programCache);
+    double shaderSeconds = glfwGetTime() - shaderStart;
+    Uniform<glm::mat4> beltModelUniform = beltProgram.uniform<glm::mat4>("model");
+    Uniform<float> beltParticleSize = beltProgram.uniform<float>("particleSize");
+
+    // View, projection and lighting go to every program through one uniform buffer
+    pointProgram.bindUniformBlock("FrameData", frameUniformBinding);
+    beltProgram.bindUniformBlock("FrameData", frameUniformBinding);
+
+    unsigned int frameUBO;
+    glGenBuffers(1, &frameUBO);
+    glBindBuffer(GL_UNIFORM_BUFFER, frameUBO);
+    glBufferData(GL_UNIFORM_BUFFER, sizeof(FrameUniforms), NULL, GL_STREAM_DRAW);
+    glBindBufferBase(GL_UNIFORM_BUFFER, frameUniformBinding, frameUBO);
+
+    // Per-body data lives in a texture buffer on unit 1; body textures are layers of an array on unit 0
+    unsigned int objectBuffer, objectTexture;
+    glGenBuffers(1, &objectBuffer);
+    glGenTextures(1, &objectTexture);
+    glBindBuffer(GL_TEXTURE_BUFFER, objectBuffer);
+    glBufferData(GL_TEXTURE_BUFFER, sizeof(ObjectData), NULL, GL_STREAM_DRAW);
+    glBindTexture(GL_TEXTURE_BUFFER, objectTexture);
+    glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, objectBuffer);
+    std::vector<ObjectData> objectData;
+
+    // Create sphere geometry: a chain of tessellations in one buffer, picked per
+    // body so no facet is off by more than half a pixel
+    const int lodSectors[] = {64, 32, 16, 8};
+    SphereLodChain sphereLods(lodSectors, sizeof(lodSectors) / sizeof(lodSectors[0]), 0.5f, 3.0f);
+    LodSelector lodSelector;
+    const std::vector<float> &sphereVertices = sphereLods.vertices;
+    const std::vector<unsigned int> &sphereIndices = sphereLods.indices;
 
     // Vertex Buffer Object (VBO), Vertex Array Object (VAO), and Element Buffer Object (EBO)
     unsigned int VBO, VAO, EBO;
@@ -751,48 +1045,70 @@ int main()
     glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void *)(6 * sizeof(float)));
     glEnableVertexAttribArray(2);
 
-    // Create solar system with realistic relative scales and orbital periods
-    // Sun
-    CelestialBody *sun = new CelestialBody("Sun", 2.0f, 0.0f, 0.0f, 27.0f, glm::vec3(1.0f, 1.0f, 0.0f));
-    solarSystem.push_back(sun);
-
-    // Mercury - smallest planet, fastest orbit (scaled down for visibility)
-    CelestialBody *mercury = new CelestialBody("Mercury", 0.08f, 4.0f, 10.0f, 58.6f, glm::vec3(0.7f, 0.7f, 0.7f), sun, 0.0f);
-    solarSystem.push_back(mercury);
-
-    // Venus - similar size to Earth, slow rotation
-    CelestialBody *venus = new CelestialBody("Venus", 0.15f, 6.0f, 25.0f, -243.0f, glm::vec3(1.0f, 0.8f, 0.6f), sun, 45.0f);
-    solarSystem.push_back(venus);
-
-    // Earth - our home planet
-    CelestialBody *earth = new CelestialBody("Earth", 0.16f, 8.0f, 40.0f, 1.0f, glm::vec3(0.2f, 0.5f, 1.0f), sun, 90.0f);
-    solarSystem.push_back(earth);
-
-    // Mars - smaller than Earth
-    CelestialBody *mars = new CelestialBody("Mars", 0.12f, 10.0f, 75.0f, 1.03f, glm::vec3(1.0f, 0.3f, 0.2f), sun, 135.0f);
-    solarSystem.push_back(mars);
-
-    // Jupiter - largest planet, gas giant
-    CelestialBody *jupiter = new CelestialBody("Jupiter", 0.45f, 14.0f, 200.0f, 0.41f, glm::vec3(0.9f, 0.7f, 0.5f), sun, 180.0f);
-    solarSystem.push_back(jupiter);
-
-    // Saturn - second largest, with rings (we'll add rings later)
-    CelestialBody *saturn = new CelestialBody("Saturn", 0.38f, 18.0f, 500.0f, 0.45f, glm::vec3(0.9f, 0.8f, 0.6f), sun, 225.0f);
-    solarSystem.push_back(saturn);
+    // Point and ray-cast impostors need no vertex data, but the core profile still wants a VAO bound
+    unsigned int impostorVAO;
+    glGenVertexArrays(1, &impostorVAO);
+
+    // Star cluster positions are streamed into their own buffer each frame
+    unsigned int clusterVAO, clusterVBO;
+    glGenVertexArrays(1, &clusterVAO);
+    glGenBuffers(1, &clusterVBO);
+    glBindVertexArray(clusterVAO);
+    glBindBuffer(GL_ARRAY_BUFFER, clusterVBO);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void *)0);
+    glEnableVertexAttribArray(0);
+    std::vector<float> clusterPositions;
+
+    // Belts: a shared quad, per-instance positions streamed each frame as three
+    // planes (all x, then all y, then all z) and per-instance colours uploaded once
+    const float beltQuad[] = {-1.0f, -1.0f, 1.0f, -1.0f, -1.0f, 1.0f, 1.0f, 1.0f};
+    unsigned int beltVAO, beltQuadVBO, beltPositionVBO, beltColorVBO;
+    glGenVertexArrays(1, &beltVAO);
+    glGenBuffers(1, &beltQuadVBO);
+    glGenBuffers(1, &beltPositionVBO);
+    glGenBuffers(1, &beltColorVBO);
+    glBindVertexArray(beltVAO);
+    glBindBuffer(GL_ARRAY_BUFFER, beltQuadVBO);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(beltQuad), beltQuad, GL_STATIC_DRAW);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void *)0);
+    glEnableVertexAttribArray(0);
 
-    // Uranus - ice giant, tilted on its side
-    CelestialBody *uranus = new CelestialBody("Uranus", 0.27f, 22.0f, 1000.0f, -0.72f, glm::vec3(0.6f, 0.8f, 0.9f), sun, 270.0f);
-    solarSystem.push_back(uranus);
+    // Single precision is plenty for display and several times faster
+    clusterDirectSolver.singlePrecision = true;
 
-    // Neptune - farthest planet, similar to Uranus
-    CelestialBody *neptune = new CelestialBody("Neptune", 0.26f, 26.0f, 2000.0f, 0.67f, glm::vec3(0.3f, 0.5f, 0.9f), sun, 315.0f);
-    solarSystem.push_back(neptune);
+    // Asteroid belt between Mars and Jupiter and Kuiper belt beyond Neptune, in
+    // the sun's frame like the planets; periods scale from Jupiter and Neptune
+    belts.addBelt({asteroidBeltCount, 11.0, 13.0, 0.2, 15.0, 14.0, 200.0, 0xff7088a0u, 1});
+    belts.addBelt({kuiperBeltCount, 28.0, 36.0, 0.25, 25.0, 26.0, 2000.0, 0xffc0a890u, 2});
 
-    // Initialize random seed and textures
-    srand(time(0));
-    for (auto body : solarSystem)
+    const std::size_t beltCount = belts.size();
+    glBindVertexArray(beltVAO);
+    glBindBuffer(GL_ARRAY_BUFFER, beltPositionVBO);
+    glBufferData(GL_ARRAY_BUFFER, beltCount * 3 * sizeof(float), NULL, GL_STREAM_DRAW);
+    for (int axis = 0; axis < 3; axis++)
     {
-        body->initializeTexture();
+        glVertexAttribPointer(1 + axis, 1, GL_FLOAT, GL_FALSE, sizeof(float), (void *)(axis * beltCount * sizeof(float)));
+        glEnableVertexAttribArray(1 + axis);
+        glVertexAttribDivisor(1 + axis, 1);
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, beltColorVBO);
+    glBufferData(GL_ARRAY_BUFFER, beltCount * sizeof(std::uint32_t), belts.color.data(), GL_STATIC_DRAW);
+    glVertexAttribPointer(4, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(std::uint32_t), (void *)0);
+    glEnableVertexAttribArray(4);
+    glVertexAttribDivisor(4, 1);
+
+    // Upload textures as they finish, on this thread since it owns the context:
+    // each body gets a layer of a shared texture array, mip chain included
+    TextureArrayPool bodyTextures;
+    for (std::size_t i = 0; i < solarSystem.size(); i++)
+    {
+        CelestialBody &body = solarSystem[i];
+        body.texture = bodyTextures.allocate(bodyTextureSize);
+        const MipChain &chain = textureQueue.wait(i);
+        for (int level = 0; level < chain.levels(); level++)
+        {
+            bodyTextures.uploadLevel(body.texture, level, chain.level(level));
+        }
     }
 
     // Set up lighting
@@ -800,91 +1116,363 @@ int main()
 
     float lastFrame = 0.0f;
 
+    // GL calls made and skipped as redundant, shown in the title once a second
+    GLCallCounts titleCounts;
+    int titleFrames = 0;
+    float lastTitleUpdate = 0.0f;
+
+    // Only bodies whose bounds reach into the view are drawn; the title shows the last frame's counts
+    FrustumCuller culler;
+    std::size_t impostorCount = 0;
+    std::vector<int> celestialOfBody(bodies.size(), -1);
+    for (std::size_t i = 0; i < solarSystem.size(); i++)
+    {
+        celestialOfBody[(std::size_t)solarSystem[i].bodyIndex] = (int)i;
+    }
+
+    // Headless frames advance by a fixed step, so every run simulates the same scene
+    const float headlessFrameTime = 1.0f / 60.0f;
+    std::vector<double> frameSeconds;
+    bool dumpFailed = false;
+
     // Render loop
-    while (!glfwWindowShouldClose(window))
+    bool firstFrameShown = false;
+    while (!glfwWindowShouldClose(window) && (!headless.enabled || (int)frameSeconds.size() < headless.frames))
     {
-        float currentFrame = glfwGetTime();
+        double frameStart = glfwGetTime();
+        float currentFrame = (float)frameStart;
         float deltaTime = currentFrame - lastFrame;
         lastFrame = currentFrame;
+        if (headless.enabled)
+        {
+            deltaTime = headlessFrameTime;
+        }
+
+        if (currentFrame - lastTitleUpdate >= 1.0f && titleFrames > 0)
+        {
+            std::string title = "Solar System Simulation - " + std::to_string(titleFrames) + " fps, GL calls per frame: " +
+                                std::to_string(titleCounts.issued / titleFrames) + " issued, " +
+                                std::to_string(titleCounts.avoided / titleFrames) + " avoided, bodies: " +
+                                std::to_string(culler.stats.visible) + " visible (" +
+                                std::to_string(impostorCount) + " impostors), " +
+                                std::to_string(culler.stats.culled) + " culled";
+            glfwSetWindowTitle(window, title.c_str());
+            titleCounts = GLCallCounts();
+            titleFrames = 0;
+            lastTitleUpdate = currentFrame;
+        }
+        ShaderProgram::resetFrameCounts();
+
+        // A stalled frame (window drag, breakpoint) should pause the simulation, not jump it
+        const float maxFrameTime = 0.25f;
+        if (deltaTime > maxFrameTime)
+            deltaTime = maxFrameTime;
 
         // Input
         processInput(window);
 
-        // Update solar system
-        for (auto body : solarSystem)
+        // Update solar system and compute each body's world matrix once for the frame
+        scheduler.tick(bodies, deltaTime);
+
+        // Belt particles are closed-form in time, so scrubbing moves them with the planets
+        if (beltsEnabled)
         {
-            body->update(deltaTime);
+            belts.evaluate(threadPool, bodies.simulationTime);
+        }
+
+        // Narrow every body's matrix to float relative to the camera, once per body per frame
+        scheduler.rebase(bodies, camera.position);
+
+        // Advance the star cluster in fixed steps, independent of the frame rate, and report its cost now and then
+        if (clusterEnabled)
+        {
+            int previousSteps = clusterSteps;
+            clusterSteps += clusterIntegrator.advance(cluster, deltaTime);
+            if (clusterSteps / 60 != previousSteps / 60)
+            {
+                double energyError = std::abs((clusterIntegrator.energy(cluster) - clusterInitialEnergy) / clusterInitialEnergy);
+                std::cout << "Cluster step " << clusterSteps
+                          << ": build " << clusterIntegrator.forceSolver().lastTimings.buildSeconds * 1000.0 << " ms"
+                          << ", force " << clusterIntegrator.forceSolver().lastTimings.forceSeconds * 1000.0 << " ms"
+                          << ", |dE/E0| " << energyError << std::endl;
+            }
         }
 
         // Render
         glClearColor(0.0f, 0.0f, 0.1f, 1.0f); // Dark blue background
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-        // Activate shader
-        glUseProgram(shaderProgram);
-
         // Set up view and projection matrices
         glm::mat4 view = camera.getViewMatrix();
-        glm::mat4 projection = glm::perspective(glm::radians(camera.fov), 1200.0f / 800.0f, 0.1f, 1000.0f);
+        glm::mat4 projection = glm::perspective(glm::radians(camera.fov), (float)viewportWidth / (float)viewportHeight, 0.1f, 1000.0f);
+
+        // Frame constants for every program. Shading happens in camera-relative
+        // space, so the viewer is at the origin and the sun is the light.
+        FrameUniforms frame;
+        frame.view = view;
+        frame.projection = projection;
+        frame.lightPos = glm::vec4(glm::vec3(bodies.renderMatrix[sun][3]), 1.0f);
+        frame.lightColor = glm::vec4(lightColor, 1.0f);
+        frame.viewPos = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+        glBindBuffer(GL_UNIFORM_BUFFER, frameUBO);
+        glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(FrameUniforms), &frame);
+
+        // The sun is drawn enlarged, so bounds get the same margin
+        culler.cull(bodies, Frustum::fromMatrix(projection * view), 1.2f);
+
+        // Pixels covered by one unit of radius at unit distance, for choosing LODs
+        const float pixelScale = (float)viewportHeight / (2.0f * std::tan(glm::radians(camera.fov) * 0.5f));
+
+        // Gather the visible bodies' instance data, grouped by program variant,
+        // texture array and LOD level so each group is one instanced draw.
+        // Impostors are not textured, so they are grouped by variant alone.
+        const int meshLevels = sphereLods.impostorLevel();
+        const int textureArrays = std::max(1, (int)bodyTextures.arrayCount());
+        const int impostorBatches = (int)sphereVariantCount * textureArrays * meshLevels;
+        const int batchCount = impostorBatches + (int)sphereVariantCount;
+        std::vector<int> batchOfVisible(culler.visible.size());
+        std::vector<int> batchStart(batchCount + 1, 0);
+        for (std::size_t i = 0; i < culler.visible.size(); i++)
+        {
+            const CelestialBody &body = solarSystem[(std::size_t)celestialOfBody[(std::size_t)culler.visible[i]]];
+            const glm::mat4 &model = bodies.renderMatrix[body.bodyIndex];
+
+            // The camera is at the origin of render space
+            float radius = glm::length(glm::vec3(model[1])) * drawScale(body);
+            float distance = glm::length(glm::vec3(model[3]));
+            float pixelRadius = distance > radius ? radius * pixelScale / distance : 1e30f;
+            int level = lodSelector.select(sphereLods, (std::size_t)body.bodyIndex, pixelRadius);
+            int array = body.texture ? body.texture.array : 0;
+            int variant = (int)sphereFeatures(body);
+            batchOfVisible[i] = level == sphereLods.impostorLevel() ? impostorBatches + variant
+                                                                     : (variant * textureArrays + array) * meshLevels + level;
+            batchStart[(std::size_t)batchOfVisible[i] + 1]++;
+        }
+        for (int batch = 0; batch < batchCount; batch++)
+        {
+            batchStart[(std::size_t)batch + 1] += batchStart[(std::size_t)batch];
+        }
 
-        // Pass matrices to shader
-        glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "view"), 1, GL_FALSE, glm::value_ptr(view));
-        glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "projection"), 1, GL_FALSE, glm::value_ptr(projection));
+        std::vector<int> batchFill(batchStart.begin(), batchStart.end() - 1);
+        objectData.resize(culler.visible.size());
+        for (std::size_t i = 0; i < culler.visible.size(); i++)
+        {
+            const CelestialBody &body = solarSystem[(std::size_t)celestialOfBody[(std::size_t)culler.visible[i]]];
+            float scale = drawScale(body);
+            glm::mat4 model = glm::scale(bodies.renderMatrix[body.bodyIndex], glm::vec3(scale));
+            glm::mat3 normalMatrix = bodies.normalMatrix[body.bodyIndex] / scale;
+
+            ObjectData &object = objectData[(std::size_t)batchFill[(std::size_t)batchOfVisible[i]]++];
+            object.model = model;
+            object.normalMatrix[0] = glm::vec4(normalMatrix[0], (float)body.texture.layer);
+            object.normalMatrix[1] = glm::vec4(normalMatrix[1], 0.0f);
+            object.normalMatrix[2] = glm::vec4(normalMatrix[2], 0.0f);
+            object.color = glm::vec4(body.color, 1.0f);
+        }
 
-        // Pass lighting uniforms - use sun's position as light source
-        glm::vec3 lightPos = sun->getModelMatrix()[3]; // Get sun's world position
-        glUniform3fv(glGetUniformLocation(shaderProgram, "lightPos"), 1, glm::value_ptr(lightPos));
-        glUniform3fv(glGetUniformLocation(shaderProgram, "lightColor"), 1, glm::value_ptr(lightColor));
-        glUniform3fv(glGetUniformLocation(shaderProgram, "viewPos"), 1, glm::value_ptr(camera.position));
+        // Orphan the buffer so the driver need not wait for last frame's draw
+        glBindBuffer(GL_TEXTURE_BUFFER, objectBuffer);
+        glBufferData(GL_TEXTURE_BUFFER, objectData.size() * sizeof(ObjectData), objectData.data(), GL_STREAM_DRAW);
 
-        // Draw all celestial bodies
-        for (auto body : solarSystem)
-        {
-            glm::mat4 model = body->getModelMatrix();
-            glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "model"), 1, GL_FALSE, glm::value_ptr(model));
-            glUniform3fv(glGetUniformLocation(shaderProgram, "objectColor"), 1, glm::value_ptr(body->color));
+        glActiveTexture(GL_TEXTURE1);
+        glBindTexture(GL_TEXTURE_BUFFER, objectTexture);
+        glActiveTexture(GL_TEXTURE0);
 
-            // Special lighting for the sun - it should glow and not be affected by shadows
-            if (body->name == "Sun")
+        // Draws are sorted by variant, so each program is bound once. Each texture
+        // array is bound once too while every body shares the same array.
+        int boundArray = -1;
+        for (unsigned variant = 0; variant < sphereVariantCount; variant++)
+        {
+            for (int array = 0; array < textureArrays; array++)
             {
-                glUniform1i(glGetUniformLocation(shaderProgram, "useTexture"), true);                                            // Enable texture for sun
-                glUniform3fv(glGetUniformLocation(shaderProgram, "lightColor"), 1, glm::value_ptr(glm::vec3(3.0f, 2.5f, 2.0f))); // Brighter, warmer light
+                int firstBatch = ((int)variant * textureArrays + array) * meshLevels;
+                int first = batchStart[(std::size_t)firstBatch];
+                GLsizei sphereInstances = (GLsizei)(batchStart[(std::size_t)(firstBatch + meshLevels)] - first);
+                if (sphereInstances == 0)
+                    continue;
+
+                if ((variant & SphereTextured) && array != boundArray && array < (int)bodyTextures.arrayCount())
+                {
+                    glBindTexture(GL_TEXTURE_2D_ARRAY, bodyTextures.texture(array));
+                    boundArray = array;
+                }
+
+                // Ray-cast impostors need no LOD: every body above point size is one quad
+                if (rayCastSpheres)
+                {
+                    ShaderVariantCache<SphereBindings>::Variant &rayCast = rayCastVariants.get(variant);
+                    rayCast.program.use();
+                    rayCast.bindings.firstInstance.set(first);
+                    glBindVertexArray(impostorVAO);
+                    glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, sphereInstances);
+                    continue;
+                }
 
-                // Draw sun with larger scale for better visibility
-                glm::mat4 sunModel = glm::scale(model, glm::vec3(1.2f)); // Make sun slightly larger
-                glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "model"), 1, GL_FALSE, glm::value_ptr(sunModel));
+                ShaderVariantCache<SphereBindings>::Variant &mesh = meshVariants.get(variant);
+                mesh.program.use();
+                glBindVertexArray(VAO);
+                for (int level = 0; level < meshLevels; level++)
+                {
+                    const SphereLodLevel &lod = sphereLods.levels[(std::size_t)level];
+                    int batch = firstBatch + level;
+                    GLsizei instances = (GLsizei)(batchStart[(std::size_t)batch + 1] - batchStart[(std::size_t)batch]);
+                    if (instances == 0)
+                        continue;
+                    mesh.bindings.firstInstance.set(batchStart[(std::size_t)batch]);
+                    glDrawElementsInstancedBaseVertex(GL_TRIANGLES, (GLsizei)lod.indexCount, GL_UNSIGNED_INT,
+                                                      (void *)(lod.firstIndex * sizeof(unsigned int)), instances, lod.baseVertex);
+                }
             }
-            else
+        }
+
+        // Bodies only a few pixels across become lit point sprites
+        impostorCount = (std::size_t)(batchStart[(std::size_t)batchCount] - batchStart[(std::size_t)impostorBatches]);
+        if (impostorCount > 0)
+        {
+            glEnable(GL_PROGRAM_POINT_SIZE);
+            glBindVertexArray(impostorVAO);
+            for (unsigned variant = 0; variant < sphereVariantCount; variant++)
             {
-                glUniform1i(glGetUniformLocation(shaderProgram, "useTexture"), body->useTexture);
-                glUniform3fv(glGetUniformLocation(shaderProgram, "lightColor"), 1, glm::value_ptr(lightColor)); // Normal light
+                int batch = impostorBatches + (int)variant;
+                GLsizei instances = (GLsizei)(batchStart[(std::size_t)batch + 1] - batchStart[(std::size_t)batch]);
+                if (instances == 0)
+                    continue;
+                ShaderVariantCache<SphereBindings>::Variant &impostor = impostorVariants.get(variant & SphereEmissive);
+                impostor.program.use();
+                impostor.bindings.firstInstance.set(batchStart[(std::size_t)batch]);
+                impostor.bindings.pixelScale.set(pixelScale);
+                glDrawArraysInstanced(GL_POINTS, 0, 1, instances);
             }
+            glDisable(GL_PROGRAM_POINT_SIZE);
+        }
+
+        // Draw both belts with one instanced draw, placed in the sun's frame as the planets are
+        if (beltsEnabled)
+        {
+            const glm::mat4 &sunMatrix = bodies.renderMatrix[sun];
+            glm::mat4 beltModel = glm::translate(glm::mat4(1.0f), glm::vec3(sunMatrix[3]));
+            beltModel = glm::scale(beltModel, glm::vec3(glm::length(glm::vec3(sunMatrix[1]))));
+
+            beltProgram.use();
+            beltModelUniform.set(beltModel);
+            beltParticleSize.set(0.03f);
+
+            // Orphan the buffer so the driver need not wait for last frame's draw
+            const std::size_t planeBytes = beltCount * sizeof(float);
+            glBindVertexArray(beltVAO);
+            glBindBuffer(GL_ARRAY_BUFFER, beltPositionVBO);
+            glBufferData(GL_ARRAY_BUFFER, 3 * planeBytes, NULL, GL_STREAM_DRAW);
+            glBufferSubData(GL_ARRAY_BUFFER, 0, planeBytes, belts.x.data());
+            glBufferSubData(GL_ARRAY_BUFFER, planeBytes, planeBytes, belts.y.data());
+            glBufferSubData(GL_ARRAY_BUFFER, 2 * planeBytes, planeBytes, belts.z.data());
+            glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, (GLsizei)beltCount);
+        }
+
+        // Draw the star cluster as points, floating above the plane of the planets
+        if (clusterEnabled)
+        {
+            clusterPositions.resize(cluster.size() * 3);
+            for (std::size_t i = 0; i < cluster.size(); i++)
+            {
+                clusterPositions[i * 3 + 0] = (float)cluster.x[i];
+                clusterPositions[i * 3 + 1] = (float)cluster.y[i];
+                clusterPositions[i * 3 + 2] = (float)cluster.z[i];
+            }
+
+            glm::mat4 clusterModel = glm::translate(glm::mat4(1.0f), glm::vec3(glm::dvec3(0.0, 12.0, 0.0) - camera.position));
+            clusterModel = glm::scale(clusterModel, glm::vec3(2.0f));
 
-            // Bind texture and set texture uniforms
-            glActiveTexture(GL_TEXTURE0);
-            glBindTexture(GL_TEXTURE_2D, body->textureID);
-            glUniform1i(glGetUniformLocation(shaderProgram, "diffuseTexture"), 0);
+            pointProgram.use();
+            pointModel.set(clusterModel);
+            pointColor.set(glm::vec3(1.0f, 0.9f, 0.7f));
 
-            glBindVertexArray(VAO);
-            glDrawElements(GL_TRIANGLES, sphereIndices.size(), GL_UNSIGNED_INT, 0);
+            glBindVertexArray(clusterVAO);
+            glBindBuffer(GL_ARRAY_BUFFER, clusterVBO);
+            glBufferData(GL_ARRAY_BUFFER, clusterPositions.size() * sizeof(float), clusterPositions.data(), GL_STREAM_DRAW);
+            glDrawArrays(GL_POINTS, 0, (GLsizei)cluster.size());
         }
 
-        // Swap buffers and poll IO events
-        glfwSwapBuffers(window);
+        titleCounts.issued += ShaderProgram::frameCounts().issued;
+        titleCounts.avoided += ShaderProgram::frameCounts().avoided;
+        titleFrames++;
+
+        // Swap buffers and poll IO events. Headless frames have nothing to swap;
+        // finishing instead makes each frame's time include its GPU work.
+        if (headless.enabled)
+        {
+            glFinish();
+            frameSeconds.push_back(glfwGetTime() - frameStart);
+
+            int frame = (int)frameSeconds.size() - 1;
+            if (!headless.dumpDirectory.empty() && frame % headless.dumpEvery == 0)
+            {
+                char name[32];
+                std::snprintf(name, sizeof(name), "/frame_%05d.ppm", frame);
+                if (!offscreen->writePpm(headless.dumpDirectory + name))
+                {
+                    // Stop rather than render frames nobody will see; the run exits with an error
+                    std::cerr << "Could not write " << headless.dumpDirectory + name << std::endl;
+                    dumpFailed = true;
+                    glfwSetWindowShouldClose(window, true);
+                }
+            }
+        }
+        else
+        {
+            glfwSwapBuffers(window);
+        }
         glfwPollEvents();
+
+        // Startup cost, to compare cold texture and program caches with warm ones
+        if (!firstFrameShown)
+        {
+            firstFrameShown = true;
+            std::cout << "First frame after " << glfwGetTime() * 1000.0 << " ms, textures " << textureCache.hits
+                      << " cached, " << textureCache.misses << " generated";
+            if (textureCache.rejected > 0)
+            {
+                std::cout << " (" << textureCache.rejected << " corrupt)";
+            }
+            std::cout << ", shaders " << shaderSeconds * 1000.0 << " ms (program cache: ";
+            if (programCache.enabled())
+            {
+                std::cout << programCache.hits << " loaded, " << programCache.misses << " compiled, "
+                          << programCache.rejected << " rejected)" << std::endl;
+            }
+            else
+            {
+                std::cout << "unsupported by driver)" << std::endl;
+            }
+        }
     }
 
+    printFrameTimings(frameSeconds, std::cout);
+
     // Clean up
-    for (auto body : solarSystem)
+    if (offscreen)
     {
-        delete body;
+        offscreen->destroy();
     }
-
     glDeleteVertexArrays(1, &VAO);
     glDeleteBuffers(1, &VBO);
     glDeleteBuffers(1, &EBO);
-    glDeleteProgram(shaderProgram);
+    glDeleteVertexArrays(1, &impostorVAO);
+    glDeleteVertexArrays(1, &clusterVAO);
+    glDeleteBuffers(1, &clusterVBO);
+    glDeleteVertexArrays(1, &beltVAO);
+    glDeleteBuffers(1, &beltQuadVBO);
+    glDeleteBuffers(1, &beltPositionVBO);
+    glDeleteBuffers(1, &beltColorVBO);
+    glDeleteBuffers(1, &frameUBO);
+    glDeleteBuffers(1, &objectBuffer);
+    glDeleteTextures(1, &objectTexture);
+    bodyTextures.destroy();
+    meshVariants.destroy();
+    rayCastVariants.destroy();
+    impostorVariants.destroy();
+    pointProgram.destroy();
+    beltProgram.destroy();
 
     glfwTerminate();
-    return 0;
+    return dumpFailed ? -1 : 0;
 }
\ No newline at end of file
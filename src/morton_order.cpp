@@ -0,0 +1,117 @@
+#include "morton_order.h"
+
+#include <algorithm>
+#include <limits>
+#include <mutex>
+
+namespace
+{
+std::uint64_t spreadBits(std::uint64_t v)
+{
+    v &= 0x1fffff;
+    v = (v | v << 32) & 0x1f00000000ffffULL;
+    v = (v | v << 16) & 0x1f0000ff0000ffULL;
+    v = (v | v << 8) & 0x100f00f00f00f00fULL;
+    v = (v | v << 4) & 0x10c30c30c30c30c3ULL;
+    v = (v | v << 2) & 0x1249249249249249ULL;
+    return v;
+}
+}
+
+double boundingCube(ThreadPool &pool, const ParticleSystem &particles, glm::dvec3 &low)
+{
+    // Reduced per chunk
+    low = glm::dvec3(std::numeric_limits<double>::max());
+    glm::dvec3 high(-std::numeric_limits<double>::max());
+    std::mutex boundsMutex;
+    pool.parallelFor(particles.size(), 16384, [&](std::size_t begin, std::size_t end)
+                     {
+        glm::dvec3 chunkLow(std::numeric_limits<double>::max());
+        glm::dvec3 chunkHigh(-std::numeric_limits<double>::max());
+        for (std::size_t i = begin; i < end; i++)
+        {
+            glm::dvec3 p(particles.x[i], particles.y[i], particles.z[i]);
+            chunkLow = glm::min(chunkLow, p);
+            chunkHigh = glm::max(chunkHigh, p);
+        }
+        std::lock_guard<std::mutex> lock(boundsMutex);
+        low = glm::min(low, chunkLow);
+        high = glm::max(high, chunkHigh); });
+
+    glm::dvec3 span = high - low;
+    return std::max(std::max(span.x, span.y), std::max(span.z, 1e-12)) * 1.0001;
+}
+
+void mortonSort(ThreadPool &pool, const ParticleSystem &particles, const glm::dvec3 &low, double extent,
+                std::vector<std::uint64_t> &codes, std::vector<int> &order)
+{
+    const std::size_t n = particles.size();
+    const double cells = (double)(1u << mortonBits);
+    const double toCell = cells / extent;
+
+    std::vector<std::pair<std::uint64_t, int>> keys(n);
+    pool.parallelFor(n, 16384, [&](std::size_t begin, std::size_t end)
+                     {
+        for (std::size_t i = begin; i < end; i++)
+        {
+            auto cell = [&](double v, double origin)
+            { return (std::uint64_t)std::min((v - origin) * toCell, cells - 1.0); };
+            std::uint64_t code = spreadBits(cell(particles.x[i], low.x)) << 2 |
+                                 spreadBits(cell(particles.y[i], low.y)) << 1 |
+                                 spreadBits(cell(particles.z[i], low.z));
+            keys[i] = {code, (int)i};
+        } });
+
+    // Sort one run per thread, then merge neighbouring runs in parallel rounds
+    std::size_t runs = std::min<std::size_t>(pool.size(), std::max<std::size_t>(n / 16384, 1));
+    std::size_t runLength = (n + runs - 1) / runs;
+    pool.parallelFor(runs, 1, [&](std::size_t begin, std::size_t end)
+                     {
+        for (std::size_t r = begin; r < end; r++)
+        {
+            std::sort(keys.begin() + std::min(r * runLength, n), keys.begin() + std::min((r + 1) * runLength, n));
+        } });
+    for (std::size_t width = runLength; width < n; width *= 2)
+    {
+        std::size_t pairs = (n + 2 * width - 1) / (2 * width);
+        pool.parallelFor(pairs, 1, [&](std::size_t begin, std::size_t end)
+                         {
+            for (std::size_t p = begin; p < end; p++)
+            {
+                std::size_t first = p * 2 * width;
+                std::size_t middle = std::min(first + width, n);
+                std::size_t last = std::min(first + 2 * width, n);
+                std::inplace_merge(keys.begin() + first, keys.begin() + middle, keys.begin() + last);
+            } });
+    }
+
+    codes.resize(n);
+    order.resize(n);
+    pool.parallelFor(n, 16384, [&](std::size_t begin, std::size_t end)
+                     {
+        for (std::size_t k = begin; k < end; k++)
+        {
+            codes[k] = keys[k].first;
+            order[k] = keys[k].second;
+        } });
+}
+
+int splitOctants(const std::vector<std::uint64_t> &codes, int begin, int end, int level, int bounds[9])
+{
+    int shift = 3 * (mortonBits - 1 - level);
+    int count = 0;
+    int start = begin;
+    for (std::uint64_t octant = 0; octant < 8 && start < end; octant++)
+    {
+        int stop = (int)(std::partition_point(codes.begin() + start, codes.begin() + end,
+                                              [&](std::uint64_t code) { return ((code >> shift) & 7) <= octant; }) -
+                         codes.begin());
+        if (stop > start)
+        {
+            bounds[count++] = start;
+            start = stop;
+        }
+    }
+    bounds[count] = end;
+    return count;
+}
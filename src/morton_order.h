@@ -0,0 +1,25 @@
+#pragma once
+
+#include "particle_system.h"
+#include "thread_pool.h"
+
+#include <cstdint>
+#include <vector>
+
+// Morton (Z-order) sorting shared by the tree codes. Sorting particles along
+// the curve puts every octree cell's particles in one contiguous range.
+
+// 21 bits per axis fill a 63-bit Morton code
+const int mortonBits = 21;
+
+// Smallest cube holding every particle; returns its edge length and sets low to its corner
+double boundingCube(ThreadPool &pool, const ParticleSystem &particles, glm::dvec3 &low);
+
+// Morton codes of the particles within the cube, sorted; order[k] is the
+// particle with the k-th smallest code
+void mortonSort(ThreadPool &pool, const ParticleSystem &particles, const glm::dvec3 &low, double extent,
+                std::vector<std::uint64_t> &codes, std::vector<int> &order);
+
+// Split the sorted range [begin, end) into its non-empty octants at the given
+// level. Writes count + 1 boundaries and returns count.
+int splitOctants(const std::vector<std::uint64_t> &codes, int begin, int end, int level, int bounds[9]);
@@ -0,0 +1,16 @@
+#include "normal_matrix.h"
+
+void computeUniformScaleNormalMatrices(const glm::mat4 *models, std::size_t count, glm::mat3 *normals)
+{
+    for (std::size_t i = 0; i < count; i++)
+    {
+        // Any column has length s; the Y axis is the one BodyStore scales parents by
+        const glm::mat4 &m = models[i];
+        float scale2 = m[1][0] * m[1][0] + m[1][1] * m[1][1] + m[1][2] * m[1][2];
+        float invScale2 = scale2 > 0.0f ? 1.0f / scale2 : 0.0f;
+        for (int column = 0; column < 3; column++)
+        {
+            normals[i][column] = glm::vec3(m[column]) * invScale2;
+        }
+    }
+}
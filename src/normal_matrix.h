@@ -0,0 +1,11 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+
+// Normal matrices (the inverse transpose of the upper 3x3) for models known to
+// be a rotation times a uniform scale s, as every BodyStore matrix is. Computed
+// once per body rather than once per vertex in the shader; the normal matrix of
+// such a model is M / s^2, so no inverse is needed.
+void computeUniformScaleNormalMatrices(const glm::mat4 *models, std::size_t count, glm::mat3 *normals);
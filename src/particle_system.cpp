@@ -0,0 +1,124 @@
+#include "particle_system.h"
+
+#include <cmath>
+#include <random>
+
+int ParticleSystem::add(const glm::dvec3 &position, const glm::dvec3 &velocity, double m)
+{
+    int index = (int)size();
+
+    x.push_back(position.x);
+    y.push_back(position.y);
+    z.push_back(position.z);
+    vx.push_back(velocity.x);
+    vy.push_back(velocity.y);
+    vz.push_back(velocity.z);
+    ax.push_back(0.0);
+    ay.push_back(0.0);
+    az.push_back(0.0);
+    mass.push_back(m);
+    potential.push_back(0.0);
+
+    return index;
+}
+
+void ParticleSystem::reserve(std::size_t count)
+{
+    for (auto *array : {&x, &y, &z, &vx, &vy, &vz, &ax, &ay, &az, &mass, &potential})
+    {
+        array->reserve(count);
+    }
+}
+
+void ParticleSystem::clear()
+{
+    for (auto *array : {&x, &y, &z, &vx, &vy, &vz, &ax, &ay, &az, &mass, &potential})
+    {
+        array->clear();
+    }
+}
+
+double ParticleSystem::kineticEnergy() const
+{
+    double energy = 0.0;
+    for (std::size_t i = 0; i < size(); i++)
+    {
+        energy += 0.5 * mass[i] * (vx[i] * vx[i] + vy[i] * vy[i] + vz[i] * vz[i]);
+    }
+    return energy;
+}
+
+double ParticleSystem::potentialEnergy() const
+{
+    // Each pair appears in both particles' potentials
+    double energy = 0.0;
+    for (std::size_t i = 0; i < size(); i++)
+    {
+        energy += 0.5 * mass[i] * potential[i];
+    }
+    return energy;
+}
+
+static glm::dvec3 randomDirection(std::mt19937 &rng)
+{
+    std::uniform_real_distribution<double> uniform(-1.0, 1.0);
+    double cosTheta = uniform(rng);
+    double phi = 3.14159265358979323846 * uniform(rng);
+    double sinTheta = std::sqrt(1.0 - cosTheta * cosTheta);
+    return glm::dvec3(sinTheta * std::cos(phi), sinTheta * std::sin(phi), cosTheta);
+}
+
+void createPlummerSphere(ParticleSystem &particles, std::size_t count, double totalMass,
+                         double scaleRadius, double gravitationalConstant, unsigned seed)
+{
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<double> uniform(0.0, 1.0);
+
+    // Generated in Henon units (G = M = a = 1), then scaled
+    double velocityScale = std::sqrt(gravitationalConstant * totalMass / scaleRadius);
+    double m = totalMass / (double)count;
+
+    glm::dvec3 centre(0.0), drift(0.0);
+    std::size_t first = particles.size();
+    particles.reserve(first + count);
+
+    for (std::size_t i = 0; i < count; i++)
+    {
+        // Radius from the inverted cumulative mass profile; discard the far tail
+        double r;
+        do
+        {
+            double fraction = uniform(rng);
+            r = 1.0 / std::sqrt(std::pow(fraction, -2.0 / 3.0) - 1.0);
+        } while (r > 20.0);
+
+        // Speed as a fraction q of the local escape speed, by rejection from q^2 (1 - q^2)^3.5
+        double q, g;
+        do
+        {
+            q = uniform(rng);
+            g = 0.1 * uniform(rng);
+        } while (g > q * q * std::pow(1.0 - q * q, 3.5));
+        double speed = q * std::sqrt(2.0) * std::pow(1.0 + r * r, -0.25);
+
+        glm::dvec3 position = randomDirection(rng) * (r * scaleRadius);
+        glm::dvec3 velocity = randomDirection(rng) * (speed * velocityScale);
+        particles.add(position, velocity, m);
+
+        centre += position * m;
+        drift += velocity * m;
+    }
+
+    // Move to the centre-of-mass frame
+    centre /= totalMass;
+    drift /= totalMass;
+    for (std::size_t i = first; i < particles.size(); i++)
+    {
+        particles.x[i] -= centre.x;
+        particles.y[i] -= centre.y;
+        particles.z[i] -= centre.z;
+        particles.vx[i] -= drift.x;
+        particles.vy[i] -= drift.y;
+        particles.vz[i] -= drift.z;
+    }
+}
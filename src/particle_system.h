@@ -0,0 +1,36 @@
+#pragma once
+
+#include "aligned_allocator.h"
+
+#include <glm/glm.hpp>
+#include <cstddef>
+
+// Structure-of-arrays state for self-gravitating point masses (asteroid swarms,
+// star clusters). Units are chosen by the caller; the solvers take G as a parameter.
+class ParticleSystem
+{
+public:
+    AlignedVector<double> x, y, z;
+    AlignedVector<double> vx, vy, vz;
+    AlignedVector<double> ax, ay, az;
+    AlignedVector<double> mass;
+
+    // Gravitational potential per unit mass, filled in by the force solvers
+    AlignedVector<double> potential;
+
+    int add(const glm::dvec3 &position, const glm::dvec3 &velocity, double m);
+    void reserve(std::size_t count);
+    void clear();
+    std::size_t size() const { return mass.size(); }
+
+    double kineticEnergy() const;
+
+    // Uses the potentials from the last force evaluation
+    double potentialEnergy() const;
+    double totalEnergy() const { return kineticEnergy() + potentialEnergy(); }
+};
+
+// Fill particles with an equal-mass Plummer sphere in virial equilibrium
+// (Aarseth, Henon & Wielen 1974), centred on the origin with zero net momentum
+void createPlummerSphere(ParticleSystem &particles, std::size_t count, double totalMass,
+                         double scaleRadius, double gravitationalConstant, unsigned seed);
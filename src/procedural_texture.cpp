@@ -0,0 +1,175 @@
+#include "procedural_texture.h"
+
+#include "aligned_allocator.h"
+
+#include <algorithm>
+
+namespace
+{
+// Body name to texture pattern. Looked up once per texture; bodies not listed get TexturePattern::Rocky.
+struct TexturePatternEntry
+{
+    const char *name;
+    TexturePattern pattern;
+};
+
+const TexturePatternEntry texturePatterns[] = {
+    {"Sun", TexturePattern::Sun},
+    {"Earth", TexturePattern::Earth},
+    {"Mars", TexturePattern::Mars},
+    {"Jupiter", TexturePattern::Jupiter},
+    {"Saturn", TexturePattern::Saturn},
+    {"Uranus", TexturePattern::Uranus},
+    {"Neptune", TexturePattern::Neptune},
+};
+
+const TextureKernel *kernelsFor(SimdLevel level)
+{
+    switch (level)
+    {
+    case SimdLevel::AVX512:
+        return avx512TextureKernels();
+    case SimdLevel::AVX2:
+        return avx2TextureKernels();
+    case SimdLevel::SSE42:
+        // Nothing in SSE4.2 helps these loops over the baseline build
+        return nullptr;
+    case SimdLevel::Scalar:
+        break;
+    }
+    return scalarTextureKernels();
+}
+
+bool available(SimdLevel level)
+{
+    return kernelsFor(level) != nullptr && cpuSupports(level);
+}
+}
+
+TexturePattern texturePatternFor(const std::string &name)
+{
+    for (const TexturePatternEntry &entry : texturePatterns)
+    {
+        if (name == entry.name)
+        {
+            return entry.pattern;
+        }
+    }
+    return TexturePattern::Rocky;
+}
+
+SimdLevel textureSimdLevel(SimdLevel level)
+{
+    while (level != SimdLevel::Scalar && !available(level))
+    {
+        level = (SimdLevel)((int)level - 1);
+    }
+    return level;
+}
+
+void generateProceduralTextureRows(TexturePattern pattern, std::uint32_t seed, int width, int height, int firstRow,
+                                   int endRow, unsigned char *pixels, SimdLevel level)
+{
+    AlignedVector<float> scratch(textureKernelScratchFloats(width));
+    TextureKernelJob job = {width, height, firstRow, endRow, seed, pixels, scratch.data()};
+    kernelsFor(textureSimdLevel(level))[(int)pattern](job);
+}
+
+void generateProceduralTextureRows(const std::string &name, int size, int firstRow, int endRow, unsigned char *pixels)
+{
+    generateProceduralTextureRows(texturePatternFor(name), textureSeed(name), size, size, firstRow, endRow, pixels);
+}
+
+std::vector<unsigned char> generateProceduralTexture(const std::string &name, int size)
+{
+    std::vector<unsigned char> pixels((std::size_t)size * size * 3);
+    generateProceduralTextureRows(name, size, 0, size, pixels.data());
+    return pixels;
+}
+
+ProceduralTextureQueue::ProceduralTextureQueue(ThreadPool &pool, int size, TextureCache *cache, int tileRows)
+    : pool(pool), textureSize(size), cache(cache), tileRows(std::max(1, tileRows))
+{
+}
+
+ProceduralTextureQueue::~ProceduralTextureQueue()
+{
+    // Queued tiles write into our buffers, so they must finish first
+    for (std::size_t i = 0; i < textures.size(); i++)
+    {
+        wait(i);
+    }
+}
+
+void ProceduralTextureQueue::generateTiles(Texture &texture)
+{
+    for (;;)
+    {
+        int tile = texture.nextTile.fetch_add(1);
+        if (tile >= texture.tileCount)
+        {
+            return;
+        }
+        int firstRow = tile * tileRows;
+        generateProceduralTextureRows(texture.pattern, texture.seed, textureSize, textureSize, firstRow,
+                                      std::min(textureSize, firstRow + tileRows), texture.chain.pixels.data());
+
+        if (texture.tilesDone.fetch_add(1) + 1 == texture.tileCount)
+        {
+            buildMipChain(textureSize, textureSize, texture.chain.pixels.data());
+            if (cache)
+            {
+                cache->store(texture.cacheKey, texture.chain);
+            }
+        }
+    }
+}
+
+std::size_t ProceduralTextureQueue::add(const std::string &name)
+{
+    std::unique_ptr<Texture> texture(new Texture());
+    texture->pattern = texturePatternFor(name);
+    texture->seed = textureSeed(name);
+
+    // Everything the pixels depend on besides the size, which the key adds
+    const std::uint32_t parameters[2] = {(std::uint32_t)texture->pattern, texture->seed};
+    texture->cacheKey = TextureCache::key("procedural", textureGeneratorVersion, parameters, sizeof(parameters),
+                                          textureSize, textureSize);
+    if (cache && cache->load(texture->cacheKey, textureSize, textureSize, texture->chain))
+    {
+        textures.push_back(std::move(texture));
+        return textures.size() - 1;
+    }
+
+    MipChain &chain = texture->chain;
+    chain.width = chain.height = textureSize;
+    chain.offsets = mipLevelOffsets(textureSize, textureSize);
+    chain.pixels.resize(chain.offsets.back());
+    texture->tileCount = (textureSize + tileRows - 1) / tileRows;
+
+    // One task per worker, each taking tiles until none are left. A pool without
+    // workers gets none, and wait() generates every tile itself.
+    Texture *queued = texture.get();
+    int taskCount = std::min(texture->tileCount, (int)pool.size() - 1);
+    for (int t = 0; t < taskCount; t++)
+    {
+        texture->tasks.push_back(pool.submit([this, queued]() { generateTiles(*queued); }));
+    }
+    textures.push_back(std::move(texture));
+    return textures.size() - 1;
+}
+
+const MipChain &ProceduralTextureQueue::wait(std::size_t index)
+{
+    // Help with the tiles nobody has started instead of sitting idle
+    Texture &texture = *textures[index];
+    generateTiles(texture);
+    for (std::future<void> &task : texture.tasks)
+    {
+        if (task.valid())
+        {
+            task.get();
+        }
+    }
+    return texture.chain;
+}
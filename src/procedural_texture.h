@@ -0,0 +1,97 @@
+#pragma once
+
+#include "simd_level.h"
+#include "texture_cache.h"
+#include "texture_kernels.h"
+#include "thread_pool.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <future>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Pattern a body's texture is drawn with
+TexturePattern texturePatternFor(const std::string &name);
+
+// Seed of a body's texture noise: the world seed mixed with the body's name.
+// FNV-1a rather than std::hash, which differs between standard libraries.
+inline std::uint32_t textureSeed(const std::string &name, std::uint32_t worldSeed = 0)
+{
+    std::uint32_t hash = 2166136261u ^ worldSeed;
+    for (char c : name)
+    {
+        hash = (hash ^ (unsigned char)c) * 16777619u;
+    }
+    return hash;
+}
+
+// Instruction set the texture kernels run at, given the highest one wanted
+SimdLevel textureSimdLevel(SimdLevel level);
+
+// Fill rows [firstRow, endRow) of a width x height RGB8 texture with a
+// pattern, using the best kernel up to the given instruction set. Rows may be
+// generated in any order or in parallel and give the same image. The pattern
+// is a map of the whole sphere, so any size works: square ones for the texture
+// array, or 2:1 ones (8192x4096, say) for undistorted equirectangular maps.
+void generateProceduralTextureRows(TexturePattern pattern, std::uint32_t seed, int width, int height, int firstRow,
+                                   int endRow, unsigned char *pixels, SimdLevel level = SimdLevel::AVX512);
+
+// The same for a body by name, in a size x size texture
+void generateProceduralTextureRows(const std::string &name, int size, int firstRow, int endRow, unsigned char *pixels);
+
+// A whole texture on the calling thread
+std::vector<unsigned char> generateProceduralTexture(const std::string &name, int size);
+
+// Procedural textures generated in tiles of rows on a thread pool while the
+// caller gets on with other work (compiling shaders, building geometry). Tiles
+// run in the order textures were added, so waiting for textures in that order
+// uploads each one as soon as it is done. wait() also generates tiles no
+// worker has started, so the caller is never idle while it waits. Textures
+// come with their whole mip chain, built by whichever thread finishes the last
+// tile. With a cache, textures found there are mapped instead of generated
+// and new ones are stored once built.
+class ProceduralTextureQueue
+{
+public:
+    ProceduralTextureQueue(ThreadPool &pool, int size, TextureCache *cache = nullptr, int tileRows = 32);
+
+    // Waits for queued tiles, which write into this queue's buffers
+    ~ProceduralTextureQueue();
+
+    ProceduralTextureQueue(const ProceduralTextureQueue &) = delete;
+    ProceduralTextureQueue &operator=(const ProceduralTextureQueue &) = delete;
+
+    // Queue the named body's texture; returns its index
+    std::size_t add(const std::string &name);
+
+    // Block until a texture and its mipmaps are complete. They stay valid while the queue lives.
+    const MipChain &wait(std::size_t texture);
+
+    std::size_t size() const { return textures.size(); }
+
+private:
+    struct Texture
+    {
+        TexturePattern pattern;
+        std::uint32_t seed;
+        std::uint64_t cacheKey;
+        MipChain chain;
+        int tileCount = 0;
+        std::atomic<int> nextTile{0}, tilesDone{0};
+        std::vector<std::future<void>> tasks;
+    };
+
+    ThreadPool &pool;
+    int textureSize;
+    TextureCache *cache;
+    int tileRows;
+
+    // Held by pointer so queued tasks keep a stable address
+    std::vector<std::unique_ptr<Texture>> textures;
+
+    // Generate unclaimed tiles until none are left; the last one also builds the mipmaps
+    void generateTiles(Texture &texture);
+};
@@ -0,0 +1,208 @@
+#include "program_cache.h"
+
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+namespace
+{
+// Tokens from GL 4.1 / ARB_get_program_binary
+const GLenum programBinaryRetrievableHint = 0x8257;
+const GLenum programBinaryLength = 0x8741;
+const GLenum numProgramBinaryFormats = 0x87FE;
+
+// File header, followed by the blob. The key is repeated so a hash collision
+// on the file name is caught.
+struct BlobHeader
+{
+    char magic[4];
+    std::uint32_t format;
+    std::uint64_t key;
+    std::uint64_t length;
+    std::uint64_t checksum;
+};
+static_assert(sizeof(BlobHeader) == 32, "the header is read straight from the file");
+const char blobMagic[4] = {'P', 'B', 'I', 'N'};
+
+// FNV-1a, continued from a previous hash
+std::uint64_t hashBytes(const void *data, std::size_t size, std::uint64_t hash = 14695981039346656037ull)
+{
+    const unsigned char *bytes = (const unsigned char *)data;
+    for (std::size_t i = 0; i < size; i++)
+    {
+        hash = (hash ^ bytes[i]) * 1099511628211ull;
+    }
+    return hash;
+}
+
+std::uint64_t hashString(const char *text, std::uint64_t hash)
+{
+    // Hash the terminator too, so "ab" + "c" differs from "a" + "bc"
+    return hashBytes(text ? text : "", text ? std::strlen(text) + 1 : 1, hash);
+}
+}
+
+ProgramBinaryCache::ProgramBinaryCache(const std::string &directory, GLADloadproc load)
+    : directory(directory)
+{
+    // Some drivers export the functions but support no binary formats at all
+    GLint formats = 0;
+    glGetIntegerv(numProgramBinaryFormats, &formats);
+    while (glGetError() != GL_NO_ERROR)
+    {
+    }
+    if (formats <= 0)
+    {
+        return;
+    }
+
+    getProgramBinary = (GetProgramBinaryProc)load("glGetProgramBinary");
+    programBinary = (ProgramBinaryProc)load("glProgramBinary");
+    programParameteri = (ProgramParameteriProc)load("glProgramParameteri");
+    if (!getProgramBinary || !programBinary || !programParameteri)
+    {
+        getProgramBinary = nullptr;
+        return;
+    }
+
+    driverHash = hashString((const char *)glGetString(GL_VENDOR), driverHash);
+    driverHash = hashString((const char *)glGetString(GL_RENDERER), driverHash);
+    driverHash = hashString((const char *)glGetString(GL_VERSION), driverHash);
+}
+
+std::uint64_t ProgramBinaryCache::key(const char *vertexSource, const char *fragmentSource) const
+{
+    return hashString(fragmentSource, hashString(vertexSource, driverHash));
+}
+
+std::string ProgramBinaryCache::path(std::uint64_t key) const
+{
+    char name[32];
+    std::snprintf(name, sizeof(name), "%016llx.bin", (unsigned long long)key);
+    return (std::filesystem::path(directory) / name).string();
+}
+
+GLuint ProgramBinaryCache::load(const char *vertexSource, const char *fragmentSource)
+{
+    if (!enabled())
+    {
+        return 0;
+    }
+
+    std::uint64_t programKey = key(vertexSource, fragmentSource);
+    std::string file = path(programKey);
+    std::error_code ignored;
+    std::uintmax_t fileSize = std::filesystem::file_size(file, ignored);
+    std::ifstream in(file, std::ios::binary);
+    if (!in || fileSize == (std::uintmax_t)-1)
+    {
+        misses++;
+        return 0;
+    }
+
+    // The length is checked against the file before it sizes anything, so a
+    // damaged header cannot ask for more memory than the file holds
+    BlobHeader header;
+    std::vector<char> blob;
+    bool valid = fileSize > sizeof(header) && in.read((char *)&header, sizeof(header)) &&
+                 std::memcmp(header.magic, blobMagic, 4) == 0 && header.key == programKey &&
+                 header.length == fileSize - sizeof(header) && header.length <= 0x7fffffff;
+    if (valid)
+    {
+        blob.resize((std::size_t)header.length);
+        valid = in.read(blob.data(), (std::streamsize)blob.size()) &&
+                hashBytes(blob.data(), blob.size()) == header.checksum;
+    }
+    in.close();
+
+    GLuint program = 0;
+    if (valid)
+    {
+        program = glCreateProgram();
+        programBinary(program, (GLenum)header.format, blob.data(), (GLsizei)blob.size());
+
+        // The driver may refuse a blob it wrote itself, e.g. after a silent update
+        int success = 0;
+        glGetProgramiv(program, GL_LINK_STATUS, &success);
+        if (!success)
+        {
+            glDeleteProgram(program);
+            program = 0;
+        }
+    }
+
+    // Truncated, damaged, or refused: build from source and store a fresh blob
+    if (program == 0)
+    {
+        std::filesystem::remove(file, ignored);
+        rejected++;
+        misses++;
+        return 0;
+    }
+    hits++;
+    return program;
+}
+
+void ProgramBinaryCache::prepare(GLuint program)
+{
+    if (enabled())
+    {
+        programParameteri(program, programBinaryRetrievableHint, GL_TRUE);
+    }
+}
+
+void ProgramBinaryCache::store(GLuint program, const char *vertexSource, const char *fragmentSource)
+{
+    if (!enabled())
+    {
+        return;
+    }
+
+    GLint length = 0;
+    glGetProgramiv(program, programBinaryLength, &length);
+    if (length <= 0)
+    {
+        return;
+    }
+
+    std::vector<char> blob((std::size_t)length);
+    GLenum format = 0;
+    GLsizei written = 0;
+    getProgramBinary(program, length, &written, &format, blob.data());
+    if (written <= 0)
+    {
+        return;
+    }
+
+    std::error_code error;
+    std::filesystem::create_directories(directory, error);
+
+    BlobHeader header;
+    std::memcpy(header.magic, blobMagic, 4);
+    header.format = format;
+    header.key = key(vertexSource, fragmentSource);
+    header.length = (std::uint64_t)written;
+    header.checksum = hashBytes(blob.data(), (std::size_t)written);
+
+    // Write to a temporary name first so a crash never leaves a truncated blob
+    std::string file = path(header.key);
+    std::string temporary = file + ".tmp";
+    {
+        std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+        if (!out || !out.write((const char *)&header, sizeof(header)) || !out.write(blob.data(), written))
+        {
+            std::cerr << "Could not write program binary " << temporary << std::endl;
+            out.close();
+            std::filesystem::remove(temporary, error);
+            return;
+        }
+    }
+    std::filesystem::rename(temporary, file, error);
+    if (error)
+    {
+        std::filesystem::remove(temporary, error);
+    }
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Linked program binaries kept on disk so later runs skip compiling and linking.
+// Entries are keyed by a hash of the shader sources together with the driver's
+// vendor, renderer and version strings, so a driver update never sees another
+// driver's blob. Each blob is stored with its length and a checksum; one that
+// fails either, or that the driver rejects, is deleted and the program is built
+// from source again. Needs GL 4.1 or ARB_get_program_binary, which the GL 3.3
+// loader does not cover, so the entry points are resolved here; without them
+// the cache is disabled and every program is compiled as before.
+class ProgramBinaryCache
+{
+public:
+    // Requires a current context. The directory is created on first store.
+    ProgramBinaryCache(const std::string &directory, GLADloadproc load);
+
+    bool enabled() const { return getProgramBinary != nullptr; }
+
+    // A linked program restored from the cache, or 0 on a miss or rejected blob
+    GLuint load(const char *vertexSource, const char *fragmentSource);
+
+    // Ask the driver to keep the binary around; call before linking
+    void prepare(GLuint program);
+
+    // Write a successfully linked program's binary to disk
+    void store(GLuint program, const char *vertexSource, const char *fragmentSource);
+
+    // Programs restored, compiled after a miss, and blobs found damaged or rejected by the driver
+    std::size_t hits = 0, misses = 0, rejected = 0;
+
+private:
+    typedef void(APIENTRYP GetProgramBinaryProc)(GLuint, GLsizei, GLsizei *, GLenum *, void *);
+    typedef void(APIENTRYP ProgramBinaryProc)(GLuint, GLenum, const void *, GLsizei);
+    typedef void(APIENTRYP ProgramParameteriProc)(GLuint, GLenum, GLint);
+
+    GetProgramBinaryProc getProgramBinary = nullptr;
+    ProgramBinaryProc programBinary = nullptr;
+    ProgramParameteriProc programParameteri = nullptr;
+
+    std::string directory;
+    std::uint64_t driverHash = 0;
+
+    std::uint64_t key(const char *vertexSource, const char *fragmentSource) const;
+    std::string path(std::uint64_t key) const;
+};
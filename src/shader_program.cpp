@@ -0,0 +1,332 @@
+#include "shader_program.h"
+#include "program_cache.h"
+
+#include <glm/gtc/type_ptr.hpp>
+
+#include <cstring>
+#include <iostream>
+
+GLuint ShaderProgram::currentProgram = 0;
+GLCallCounts ShaderProgram::counts;
+
+namespace
+{
+const GLenum boolTypes[] = {GL_BOOL, GL_INT};
+const GLenum intTypes[] = {GL_INT, GL_BOOL, GL_SAMPLER_1D, GL_SAMPLER_2D, GL_SAMPLER_3D, GL_SAMPLER_CUBE,
+                           GL_SAMPLER_2D_ARRAY, GL_SAMPLER_BUFFER, GL_INT_SAMPLER_BUFFER, GL_UNSIGNED_INT_SAMPLER_BUFFER};
+const GLenum floatTypes[] = {GL_FLOAT};
+const GLenum vec3Types[] = {GL_FLOAT_VEC3};
+const GLenum vec4Types[] = {GL_FLOAT_VEC4};
+const GLenum mat3Types[] = {GL_FLOAT_MAT3};
+const GLenum mat4Types[] = {GL_FLOAT_MAT4};
+
+GLuint compileShader(GLenum stage, const char *source, const char *stageName)
+{
+    GLuint shader = glCreateShader(stage);
+    glShaderSource(shader, 1, &source, NULL);
+    glCompileShader(shader);
+
+    int success;
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+    if (!success)
+    {
+        char infoLog[512];
+        glGetShaderInfoLog(shader, 512, NULL, infoLog);
+        std::cerr << "ERROR::SHADER::" << stageName << "::COMPILATION_FAILED\n"
+                  << infoLog << std::endl;
+    }
+    return shader;
+}
+}
+
+ShaderProgram::ShaderProgram(const char *vertexSource, const char *fragmentSource, ProgramBinaryCache *cache)
+{
+    program = cache ? cache->load(vertexSource, fragmentSource) : 0;
+    if (program != 0)
+    {
+        reflect();
+        return;
+    }
+
+    GLuint vertexShader = compileShader(GL_VERTEX_SHADER, vertexSource, "VERTEX");
+    GLuint fragmentShader = compileShader(GL_FRAGMENT_SHADER, fragmentSource, "FRAGMENT");
+
+    program = glCreateProgram();
+    glAttachShader(program, vertexShader);
+    glAttachShader(program, fragmentShader);
+    if (cache)
+    {
+        cache->prepare(program);
+    }
+    glLinkProgram(program);
+
+    int success;
+    glGetProgramiv(program, GL_LINK_STATUS, &success);
+    if (!success)
+    {
+        char infoLog[512];
+        glGetProgramInfoLog(program, 512, NULL, infoLog);
+        std::cerr << "ERROR::SHADER::PROGRAM::LINKING_FAILED\n"
+                  << infoLog << std::endl;
+    }
+
+    // The shaders are linked into the program now and no longer necessary
+    glDeleteShader(vertexShader);
+    glDeleteShader(fragmentShader);
+
+    if (success)
+    {
+        reflect();
+        if (cache)
+        {
+            cache->store(program, vertexSource, fragmentSource);
+        }
+    }
+}
+
+ShaderProgram::~ShaderProgram()
+{
+    destroy();
+}
+
+void ShaderProgram::destroy()
+{
+    if (program == 0)
+    {
+        return;
+    }
+    if (currentProgram == program)
+    {
+        currentProgram = 0;
+    }
+    glDeleteProgram(program);
+    program = 0;
+}
+
+void ShaderProgram::reflect()
+{
+    GLint uniformCount = 0, maxNameLength = 0;
+    glGetProgramiv(program, GL_ACTIVE_UNIFORMS, &uniformCount);
+    glGetProgramiv(program, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxNameLength);
+    std::vector<char> name((std::size_t)maxNameLength + 1);
+
+    for (GLint i = 0; i < uniformCount; i++)
+    {
+        // Members of uniform blocks have no location; they are set through the block's buffer
+        GLuint index = (GLuint)i;
+        GLint blockIndex = -1;
+        glGetActiveUniformsiv(program, 1, &index, GL_UNIFORM_BLOCK_INDEX, &blockIndex);
+        if (blockIndex != -1)
+        {
+            continue;
+        }
+
+        UniformInfo info;
+        GLsizei length = 0;
+        glGetActiveUniform(program, index, (GLsizei)name.size(), &length, &info.arraySize, &info.type, name.data());
+        info.name.assign(name.data(), (std::size_t)length);
+
+        // Arrays are reported as "name[0]"; look them up by their plain name
+        if (info.name.size() > 3 && info.name.compare(info.name.size() - 3, 3, "[0]") == 0)
+        {
+            info.name.resize(info.name.size() - 3);
+        }
+
+        info.location = glGetUniformLocation(program, name.data());
+        info.cached = false;
+        info.value = glm::mat4(0.0f);
+        uniformTable.push_back(info);
+    }
+
+    GLint blockCount = 0, maxBlockNameLength = 0;
+    glGetProgramiv(program, GL_ACTIVE_UNIFORM_BLOCKS, &blockCount);
+    glGetProgramiv(program, GL_ACTIVE_UNIFORM_BLOCK_MAX_NAME_LENGTH, &maxBlockNameLength);
+    std::vector<char> blockName((std::size_t)maxBlockNameLength + 1);
+
+    for (GLint i = 0; i < blockCount; i++)
+    {
+        UniformBlockInfo info;
+        GLsizei length = 0;
+        info.index = (GLuint)i;
+        glGetActiveUniformBlockName(program, info.index, (GLsizei)blockName.size(), &length, blockName.data());
+        info.name.assign(blockName.data(), (std::size_t)length);
+        glGetActiveUniformBlockiv(program, info.index, GL_UNIFORM_BLOCK_DATA_SIZE, &info.dataSize);
+        blockTable.push_back(info);
+    }
+}
+
+void ShaderProgram::use()
+{
+    if (currentProgram == program)
+    {
+        counts.avoided++;
+        return;
+    }
+    glUseProgram(program);
+    currentProgram = program;
+    counts.issued++;
+}
+
+GLuint ShaderProgram::uniformBlock(const char *name) const
+{
+    for (const UniformBlockInfo &block : blockTable)
+    {
+        if (block.name == name)
+        {
+            return block.index;
+        }
+    }
+    return GL_INVALID_INDEX;
+}
+
+void ShaderProgram::bindUniformBlock(const char *name, GLuint binding)
+{
+    GLuint index = uniformBlock(name);
+    if (index != GL_INVALID_INDEX)
+    {
+        glUniformBlockBinding(program, index, binding);
+    }
+}
+
+int ShaderProgram::find(const char *name, const GLenum *types, std::size_t typeCount) const
+{
+    for (std::size_t slot = 0; slot < uniformTable.size(); slot++)
+    {
+        const UniformInfo &info = uniformTable[slot];
+        if (info.name != name)
+        {
+            continue;
+        }
+
+        for (std::size_t t = 0; t < typeCount; t++)
+        {
+            if (info.type == types[t])
+            {
+                return (int)slot;
+            }
+        }
+        std::cerr << "Uniform '" << name << "' has GL type 0x" << std::hex << info.type << std::dec
+                  << ", which does not match the requested C++ type" << std::endl;
+        return -1;
+    }
+
+    // Uniforms the compiler removed are not errors: the shader simply does not use them
+    return -1;
+}
+
+bool ShaderProgram::update(int slot, const void *value, std::size_t size)
+{
+    UniformInfo &info = uniformTable[(std::size_t)slot];
+    if (info.cached && std::memcmp(&info.value, value, size) == 0)
+    {
+        counts.avoided++;
+        return false;
+    }
+
+    // glUniform* writes to the current program, so bind only for an actual upload
+    if (currentProgram != program)
+    {
+        glUseProgram(program);
+        currentProgram = program;
+        counts.issued++;
+    }
+    std::memcpy(&info.value, value, size);
+    info.cached = true;
+    counts.issued++;
+    return true;
+}
+
+void ShaderProgram::set(int slot, bool value)
+{
+    set(slot, (int)value);
+}
+
+void ShaderProgram::set(int slot, int value)
+{
+    if (update(slot, &value, sizeof(value)))
+    {
+        glUniform1i(uniformTable[(std::size_t)slot].location, value);
+    }
+}
+
+void ShaderProgram::set(int slot, float value)
+{
+    if (update(slot, &value, sizeof(value)))
+    {
+        glUniform1f(uniformTable[(std::size_t)slot].location, value);
+    }
+}
+
+void ShaderProgram::set(int slot, const glm::vec3 &value)
+{
+    if (update(slot, &value, sizeof(value)))
+    {
+        glUniform3fv(uniformTable[(std::size_t)slot].location, 1, glm::value_ptr(value));
+    }
+}
+
+void ShaderProgram::set(int slot, const glm::vec4 &value)
+{
+    if (update(slot, &value, sizeof(value)))
+    {
+        glUniform4fv(uniformTable[(std::size_t)slot].location, 1, glm::value_ptr(value));
+    }
+}
+
+void ShaderProgram::set(int slot, const glm::mat3 &value)
+{
+    if (update(slot, &value, sizeof(value)))
+    {
+        glUniformMatrix3fv(uniformTable[(std::size_t)slot].location, 1, GL_FALSE, glm::value_ptr(value));
+    }
+}
+
+void ShaderProgram::set(int slot, const glm::mat4 &value)
+{
+    if (update(slot, &value, sizeof(value)))
+    {
+        glUniformMatrix4fv(uniformTable[(std::size_t)slot].location, 1, GL_FALSE, glm::value_ptr(value));
+    }
+}
+
+std::size_t ShaderProgram::acceptedTypes(const bool *, const GLenum *&types)
+{
+    types = boolTypes;
+    return sizeof(boolTypes) / sizeof(boolTypes[0]);
+}
+
+std::size_t ShaderProgram::acceptedTypes(const int *, const GLenum *&types)
+{
+    types = intTypes;
+    return sizeof(intTypes) / sizeof(intTypes[0]);
+}
+
+std::size_t ShaderProgram::acceptedTypes(const float *, const GLenum *&types)
+{
+    types = floatTypes;
+    return 1;
+}
+
+std::size_t ShaderProgram::acceptedTypes(const glm::vec3 *, const GLenum *&types)
+{
+    types = vec3Types;
+    return 1;
+}
+
+std::size_t ShaderProgram::acceptedTypes(const glm::vec4 *, const GLenum *&types)
+{
+    types = vec4Types;
+    return 1;
+}
+
+std::size_t ShaderProgram::acceptedTypes(const glm::mat3 *, const GLenum *&types)
+{
+    types = mat3Types;
+    return 1;
+}
+
+std::size_t ShaderProgram::acceptedTypes(const glm::mat4 *, const GLenum *&types)
+{
+    types = mat4Types;
+    return 1;
+}
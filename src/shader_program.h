@@ -0,0 +1,151 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+class ShaderProgram;
+class ProgramBinaryCache;
+
+// GL calls made and avoided by ShaderProgram since the last resetFrameCounts()
+struct GLCallCounts
+{
+    // glUseProgram and glUniform* calls that reached the driver
+    std::size_t issued = 0;
+
+    // glUseProgram and glUniform* calls skipped because the program was already
+    // bound or the uniform already held the value. Name lookups are not counted:
+    // handles are resolved once after linking, so none happen per frame.
+    std::size_t avoided = 0;
+};
+
+// Typed handle to one active uniform, obtained once after linking. Setting a
+// handle that did not resolve (inactive or wrong type) does nothing.
+template <typename T>
+class Uniform
+{
+public:
+    Uniform() = default;
+
+    void set(const T &value) const;
+    explicit operator bool() const { return program != nullptr; }
+
+private:
+    friend class ShaderProgram;
+    Uniform(ShaderProgram *program, int slot) : program(program), slot(slot) {}
+
+    ShaderProgram *program = nullptr;
+    int slot = -1;
+};
+
+// A linked GLSL program with its active uniforms and uniform blocks reflected
+// once at link time. Uniform values are shadowed on the CPU, so setting a value
+// the program already holds costs a compare rather than a GL call.
+class ShaderProgram
+{
+public:
+    struct UniformInfo
+    {
+        std::string name;
+        GLenum type;
+        GLint arraySize;
+        GLint location;
+
+        // Last value uploaded, valid once written
+        bool cached;
+        glm::mat4 value;
+    };
+
+    struct UniformBlockInfo
+    {
+        std::string name;
+        GLuint index;
+        GLint dataSize;
+    };
+
+    // Compile and link, reporting any errors to std::cerr. With a cache, a stored
+    // binary of the same sources is loaded instead, and a fresh link is stored.
+    ShaderProgram(const char *vertexSource, const char *fragmentSource, ProgramBinaryCache *cache = nullptr);
+    ~ShaderProgram();
+
+    // Delete the GL program now, while the context is still current
+    void destroy();
+
+    ShaderProgram(const ShaderProgram &) = delete;
+    ShaderProgram &operator=(const ShaderProgram &) = delete;
+
+    GLuint id() const { return program; }
+
+    // Bind the program unless it is already current
+    void use();
+
+    // Resolve a uniform by name; returns an empty handle (and reports it) if the
+    // uniform is not active or its GLSL type does not match T
+    template <typename T>
+    Uniform<T> uniform(const char *name);
+
+    // Index of an active uniform block, or GL_INVALID_INDEX
+    GLuint uniformBlock(const char *name) const;
+
+    // Attach a uniform block to a buffer binding point; does nothing if the block is not active
+    void bindUniformBlock(const char *name, GLuint binding);
+
+    const std::vector<UniformInfo> &uniforms() const { return uniformTable; }
+    const std::vector<UniformBlockInfo> &uniformBlocks() const { return blockTable; }
+
+    static const GLCallCounts &frameCounts() { return counts; }
+    static void resetFrameCounts() { counts = GLCallCounts(); }
+
+    // Uploads for each supported type; the program is bound first if needed
+    void set(int slot, bool value);
+    void set(int slot, int value);
+    void set(int slot, float value);
+    void set(int slot, const glm::vec3 &value);
+    void set(int slot, const glm::vec4 &value);
+    void set(int slot, const glm::mat3 &value);
+    void set(int slot, const glm::mat4 &value);
+
+private:
+    GLuint program = 0;
+    std::vector<UniformInfo> uniformTable;
+    std::vector<UniformBlockInfo> blockTable;
+
+    static GLuint currentProgram;
+    static GLCallCounts counts;
+
+    void reflect();
+    int find(const char *name, const GLenum *types, std::size_t typeCount) const;
+
+    // Compare against the shadow copy; true when the value changed and must be uploaded
+    bool update(int slot, const void *value, std::size_t size);
+
+    // GLSL types each C++ type may be written to, selected by the pointer type
+    static std::size_t acceptedTypes(const bool *, const GLenum *&types);
+    static std::size_t acceptedTypes(const int *, const GLenum *&types);
+    static std::size_t acceptedTypes(const float *, const GLenum *&types);
+    static std::size_t acceptedTypes(const glm::vec3 *, const GLenum *&types);
+    static std::size_t acceptedTypes(const glm::vec4 *, const GLenum *&types);
+    static std::size_t acceptedTypes(const glm::mat3 *, const GLenum *&types);
+    static std::size_t acceptedTypes(const glm::mat4 *, const GLenum *&types);
+};
+
+template <typename T>
+void Uniform<T>::set(const T &value) const
+{
+    if (program)
+    {
+        program->set(slot, value);
+    }
+}
+
+template <typename T>
+Uniform<T> ShaderProgram::uniform(const char *name)
+{
+    const GLenum *types;
+    std::size_t typeCount = acceptedTypes((const T *)nullptr, types);
+    int slot = find(name, types, typeCount);
+    return slot >= 0 ? Uniform<T>(this, slot) : Uniform<T>();
+}
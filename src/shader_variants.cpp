@@ -0,0 +1,26 @@
+#include "shader_variants.h"
+
+std::string defineFeatures(const char *source, unsigned features, const char *const *featureNames, std::size_t featureCount)
+{
+    std::string defines;
+    for (std::size_t i = 0; i < featureCount; i++)
+    {
+        if (features & (1u << i))
+        {
+            defines += "#define ";
+            defines += featureNames[i];
+            defines += "\n";
+        }
+    }
+
+    // #version must stay the first directive, so the defines go on the line after it
+    std::string result(source);
+    std::size_t version = result.find("#version");
+    std::size_t lineEnd = version == std::string::npos ? std::string::npos : result.find('\n', version);
+    if (lineEnd == std::string::npos)
+    {
+        return defines + result;
+    }
+    result.insert(lineEnd + 1, defines);
+    return result;
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include "shader_program.h"
+
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <string>
+
+// Copy of a GLSL source with "#define NAME" inserted after its #version line
+// for every bit set in features; bit i selects featureNames[i]
+std::string defineFeatures(const char *source, unsigned features, const char *const *featureNames, std::size_t featureCount);
+
+// Specialized programs compiled from one vertex and fragment source, one per
+// combination of feature #defines, so the shaders resolve material choices at
+// compile time instead of branching per pixel. Variants are compiled on first
+// use and kept by feature key. Bindings is built from each new program to hold
+// its uniform handles and do one-time setup (sampler units, block bindings).
+template <typename Bindings>
+class ShaderVariantCache
+{
+public:
+    struct Variant
+    {
+        ShaderProgram program;
+        Bindings bindings;
+
+        Variant(const std::string &vertexSource, const std::string &fragmentSource, ProgramBinaryCache *cache)
+            : program(vertexSource.c_str(), fragmentSource.c_str(), cache), bindings(program) {}
+    };
+
+    // Programs are loaded from and stored to the binary cache when one is given
+    ShaderVariantCache(const char *vertexSource, const char *fragmentSource, const char *const *featureNames, std::size_t featureCount,
+                       ProgramBinaryCache *cache = nullptr)
+        : vertexSource(vertexSource), fragmentSource(fragmentSource), featureNames(featureNames), featureCount(featureCount),
+          cache(cache) {}
+
+    Variant &get(unsigned features)
+    {
+        std::unique_ptr<Variant> &variant = variants[features];
+        if (!variant)
+        {
+            variant.reset(new Variant(defineFeatures(vertexSource.c_str(), features, featureNames, featureCount),
+                                      defineFeatures(fragmentSource.c_str(), features, featureNames, featureCount), cache));
+        }
+        return *variant;
+    }
+
+    std::size_t size() const { return variants.size(); }
+
+    // Delete every program now, while the context is still current
+    void destroy()
+    {
+        for (auto &entry : variants)
+        {
+            entry.second->program.destroy();
+        }
+    }
+
+private:
+    std::string vertexSource, fragmentSource;
+    const char *const *featureNames;
+    std::size_t featureCount;
+    ProgramBinaryCache *cache;
+    std::map<unsigned, std::unique_ptr<Variant>> variants;
+};
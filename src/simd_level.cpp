@@ -0,0 +1,69 @@
+#include "simd_level.h"
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#endif
+
+const char *simdLevelName(SimdLevel level)
+{
+    switch (level)
+    {
+    case SimdLevel::Scalar:
+        return "Scalar";
+    case SimdLevel::SSE42:
+        return "SSE4.2";
+    case SimdLevel::AVX2:
+        return "AVX2";
+    case SimdLevel::AVX512:
+        return "AVX-512";
+    }
+    return "Unknown";
+}
+
+bool cpuSupports(SimdLevel level)
+{
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+    switch (level)
+    {
+    case SimdLevel::AVX512:
+        return __builtin_cpu_supports("avx512f");
+    case SimdLevel::AVX2:
+        return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+    case SimdLevel::SSE42:
+        return __builtin_cpu_supports("sse4.2");
+    case SimdLevel::Scalar:
+        break;
+    }
+    return true;
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+    int info[4];
+    __cpuid(info, 1);
+    bool sse42 = (info[2] & (1 << 20)) != 0;
+    bool fma = (info[2] & (1 << 12)) != 0;
+
+    // The OS must save the AVX (and for AVX-512, the opmask and upper ZMM) registers
+    bool osxsave = (info[2] & (1 << 27)) != 0;
+    unsigned long long xcr0 = osxsave ? _xgetbv(0) : 0;
+    bool osAvx = (xcr0 & 0x6) == 0x6;
+    bool osAvx512 = (xcr0 & 0xe6) == 0xe6;
+
+    __cpuidex(info, 7, 0);
+    bool avx2 = (info[1] & (1 << 5)) != 0;
+    bool avx512f = (info[1] & (1 << 16)) != 0;
+
+    switch (level)
+    {
+    case SimdLevel::AVX512:
+        return avx512f && osAvx512;
+    case SimdLevel::AVX2:
+        return avx2 && fma && osAvx;
+    case SimdLevel::SSE42:
+        return sse42;
+    case SimdLevel::Scalar:
+        break;
+    }
+    return true;
+#else
+    return level == SimdLevel::Scalar;
+#endif
+}
@@ -0,0 +1,15 @@
+#pragma once
+
+// Instruction sets the SIMD kernels are built for, lowest first
+enum class SimdLevel
+{
+    Scalar,
+    SSE42,
+    AVX2,
+    AVX512,
+};
+
+const char *simdLevelName(SimdLevel level);
+
+// Whether this CPU and OS can run code built for the level (Scalar always can)
+bool cpuSupports(SimdLevel level);
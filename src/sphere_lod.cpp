@@ -0,0 +1,144 @@
+#include "sphere_lod.h"
+
+#include <cmath>
+
+namespace
+{
+const float pi = 3.14159265358979323846f;
+}
+
+// Function to create sphere vertices with texture coordinates
+std::vector<float> createSphereVertices(float radius, int sectors, int stacks)
+{
+    std::vector<float> vertices;
+
+    for (int i = 0; i <= stacks; ++i)
+    {
+        float stackAngle = pi / 2 - i * pi / stacks;
+        float xy = radius * std::cos(stackAngle);
+        float z = radius * std::sin(stackAngle);
+
+        for (int j = 0; j <= sectors; ++j)
+        {
+            float sectorAngle = j * 2 * pi / sectors;
+
+            float x = xy * std::cos(sectorAngle);
+            float y = xy * std::sin(sectorAngle);
+
+            // Position
+            vertices.push_back(x);
+            vertices.push_back(y);
+            vertices.push_back(z);
+
+            // Normal
+            vertices.push_back(x / radius);
+            vertices.push_back(y / radius);
+            vertices.push_back(z / radius);
+
+            // Texture coordinates
+            float s = (float)j / sectors;
+            float t = (float)i / stacks;
+            vertices.push_back(s);
+            vertices.push_back(t);
+        }
+    }
+
+    return vertices;
+}
+
+// Function to create sphere indices
+std::vector<unsigned int> createSphereIndices(int sectors, int stacks)
+{
+    std::vector<unsigned int> indices;
+
+    for (int i = 0; i < stacks; ++i)
+    {
+        int k1 = i * (sectors + 1);
+        int k2 = k1 + sectors + 1;
+
+        for (int j = 0; j < sectors; ++j, ++k1, ++k2)
+        {
+            if (i != 0)
+            {
+                indices.push_back(k1);
+                indices.push_back(k2);
+                indices.push_back(k1 + 1);
+            }
+
+            if (i != (stacks - 1))
+            {
+                indices.push_back(k1 + 1);
+                indices.push_back(k2);
+                indices.push_back(k2 + 1);
+            }
+        }
+    }
+
+    return indices;
+}
+
+SphereLodChain::SphereLodChain(const int *sectors, std::size_t count, float errorPixels, float impostorPixelRadius)
+    : impostorPixelRadius(impostorPixelRadius)
+{
+    for (std::size_t k = 0; k < count; k++)
+    {
+        SphereLodLevel level;
+        level.sectors = sectors[k];
+        level.stacks = sectors[k] / 2;
+        level.baseVertex = (int)(vertices.size() / 8);
+        level.firstIndex = indices.size();
+
+        std::vector<float> levelVertices = createSphereVertices(1.0f, level.sectors, level.stacks);
+        std::vector<unsigned int> levelIndices = createSphereIndices(level.sectors, level.stacks);
+        vertices.insert(vertices.end(), levelVertices.begin(), levelVertices.end());
+        indices.insert(indices.end(), levelIndices.begin(), levelIndices.end());
+        level.indexCount = levelIndices.size();
+
+        // A facet spanning angle a sits r (1 - cos(a / 2)) inside the sphere at its middle
+        level.maxPixelRadius = errorPixels / (1.0f - std::cos(pi / (float)level.sectors));
+        levels.push_back(level);
+    }
+}
+
+int SphereLodChain::levelFor(float pixelRadius) const
+{
+    if (pixelRadius < impostorPixelRadius)
+    {
+        return impostorLevel();
+    }
+    for (int k = (int)levels.size() - 1; k > 0; k--)
+    {
+        if (pixelRadius <= levels[(std::size_t)k].maxPixelRadius)
+        {
+            return k;
+        }
+    }
+    return 0;
+}
+
+int LodSelector::select(const SphereLodChain &chain, std::size_t body, float pixelRadius)
+{
+    if (body >= current.size())
+    {
+        current.resize(body + 1, -1);
+    }
+    int &level = current[body];
+    if (level < 0)
+    {
+        level = chain.levelFor(pixelRadius);
+        return level;
+    }
+
+    // Finer only once clearly too big for this level, coarser only once clearly small enough
+    int finer = chain.levelFor(pixelRadius / (1.0f + hysteresis));
+    int coarser = chain.levelFor(pixelRadius * (1.0f + hysteresis));
+    if (finer < level)
+    {
+        level = finer;
+    }
+    else if (coarser > level)
+    {
+        level = coarser;
+    }
+    return level;
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+// Interleaved sphere vertices: position, normal and texture coordinates, 8 floats each
+std::vector<float> createSphereVertices(float radius, int sectors, int stacks);
+std::vector<unsigned int> createSphereIndices(int sectors, int stacks);
+
+struct SphereLodLevel
+{
+    int sectors, stacks;
+
+    // Where the level sits in the shared arrays; indices are relative to baseVertex
+    int baseVertex;
+    std::size_t firstIndex, indexCount;
+
+    // Largest on-screen radius, in pixels, at which the facets stay within the error tolerance
+    float maxPixelRadius;
+};
+
+// Unit sphere tessellations from finest to coarsest, packed into one vertex
+// array and one index array so they share a single VBO and EBO. Each level is
+// good up to the pixel radius at which its facets deviate from the true sphere
+// by the error tolerance; below impostorPixelRadius a body is better drawn as
+// a point sprite, which is level impostorLevel().
+class SphereLodChain
+{
+public:
+    std::vector<SphereLodLevel> levels;
+    std::vector<float> vertices;
+    std::vector<unsigned int> indices;
+    float impostorPixelRadius;
+
+    // sectors lists the levels' sector counts, finest first; each has half as many stacks
+    SphereLodChain(const int *sectors, std::size_t count, float errorPixels, float impostorPixelRadius);
+
+    int impostorLevel() const { return (int)levels.size(); }
+
+    // Coarsest level that looks exact at this on-screen radius
+    int levelFor(float pixelRadius) const;
+};
+
+// Per-body LOD choice with hysteresis: a body only changes level once its
+// pixel radius is past the threshold by a margin, so bodies near a threshold
+// do not pop back and forth as they move.
+class LodSelector
+{
+public:
+    explicit LodSelector(float hysteresis = 0.15f) : hysteresis(hysteresis) {}
+
+    int select(const SphereLodChain &chain, std::size_t body, float pixelRadius);
+
+private:
+    float hysteresis;
+
+    // Level each body was last drawn at, or -1 before its first frame
+    std::vector<int> current;
+};
@@ -0,0 +1,101 @@
+#include "texture_array_pool.h"
+
+#include <algorithm>
+#include <cmath>
+
+TextureArrayPool::TextureArrayPool(int layersPerArray)
+{
+    GLint maxLayers = 0;
+    glGetIntegerv(GL_MAX_ARRAY_TEXTURE_LAYERS, &maxLayers);
+    this->layersPerArray = std::max(1, maxLayers > 0 ? std::min(layersPerArray, (int)maxLayers) : layersPerArray);
+}
+
+TextureArrayPool::~TextureArrayPool()
+{
+    destroy();
+}
+
+void TextureArrayPool::destroy()
+{
+    for (Array &array : arrays)
+    {
+        glDeleteTextures(1, &array.texture);
+    }
+    arrays.clear();
+}
+
+TextureSlot TextureArrayPool::allocate(int size)
+{
+    TextureSlot slot;
+    for (std::size_t a = 0; a < arrays.size(); a++)
+    {
+        if (arrays[a].size == size && !arrays[a].freeLayers.empty())
+        {
+            slot.array = (int)a;
+            break;
+        }
+    }
+
+    // Every array of this size class is full: start another
+    if (!slot)
+    {
+        Array array;
+        array.size = size;
+        for (int layer = layersPerArray - 1; layer >= 0; layer--)
+        {
+            array.freeLayers.push_back(layer);
+        }
+
+        int levels = 1 + (int)std::floor(std::log2((double)size));
+        glGenTextures(1, &array.texture);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, array.texture);
+        for (int level = 0; level < levels; level++)
+        {
+            int levelSize = std::max(1, size >> level);
+            glTexImage3D(GL_TEXTURE_2D_ARRAY, level, GL_RGB8, levelSize, levelSize, layersPerArray,
+                         0, GL_RGB, GL_UNSIGNED_BYTE, NULL);
+        }
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+        slot.array = (int)arrays.size();
+        arrays.push_back(array);
+    }
+
+    Array &array = arrays[(std::size_t)slot.array];
+    slot.layer = array.freeLayers.back();
+    array.freeLayers.pop_back();
+    return slot;
+}
+
+void TextureArrayPool::free(TextureSlot slot)
+{
+    if (!slot)
+    {
+        return;
+    }
+    std::vector<int> &freeLayers = arrays[(std::size_t)slot.array].freeLayers;
+    if (std::find(freeLayers.begin(), freeLayers.end(), slot.layer) == freeLayers.end())
+    {
+        freeLayers.push_back(slot.layer);
+    }
+}
+
+void TextureArrayPool::uploadLevel(TextureSlot slot, int level, const unsigned char *pixels)
+{
+    // Rows of the small levels are not 4-byte multiples
+    Array &array = arrays[(std::size_t)slot.array];
+    int levelSize = std::max(1, array.size >> level);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, array.texture);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexSubImage3D(GL_TEXTURE_2D_ARRAY, level, 0, 0, slot.layer, levelSize, levelSize, 1,
+                    GL_RGB, GL_UNSIGNED_BYTE, pixels);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+}
+
+int TextureArrayPool::layersInUse(int array) const
+{
+    return layersPerArray - (int)arrays[(std::size_t)array].freeLayers.size();
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include <cstddef>
+#include <vector>
+
+// One layer of one array in a TextureArrayPool; array is -1 for no layer
+struct TextureSlot
+{
+    int array = -1;
+    int layer = -1;
+
+    explicit operator bool() const { return array >= 0; }
+};
+
+// Square RGB8 textures kept as layers of GL_TEXTURE_2D_ARRAY objects, so
+// everything drawn with one array needs a single bind and picks its layer per
+// instance. Arrays are grouped into size classes by edge length. A class starts
+// with one array of layersPerArray layers and gains another when it fills up;
+// freed layers are reused before a new array is made.
+class TextureArrayPool
+{
+public:
+    // layersPerArray is clamped to GL_MAX_ARRAY_TEXTURE_LAYERS
+    explicit TextureArrayPool(int layersPerArray = 16);
+    ~TextureArrayPool();
+
+    // Delete every array now, while the context is still current
+    void destroy();
+
+    TextureArrayPool(const TextureArrayPool &) = delete;
+    TextureArrayPool &operator=(const TextureArrayPool &) = delete;
+
+    TextureSlot allocate(int size);
+
+    // Return the layer to its array. Freeing a layer that is already free does
+    // nothing, so a slot freed twice is never handed to two bodies.
+    void free(TextureSlot slot);
+
+    // Copy one mip level, (size >> level) texels on a side and tightly packed;
+    // callers bring the whole chain (see MipChain), so no mipmaps are generated here
+    void uploadLevel(TextureSlot slot, int level, const unsigned char *pixels);
+
+    std::size_t arrayCount() const { return arrays.size(); }
+    GLuint texture(int array) const { return arrays[(std::size_t)array].texture; }
+    int size(int array) const { return arrays[(std::size_t)array].size; }
+    int layersInUse(int array) const;
+
+private:
+    struct Array
+    {
+        GLuint texture;
+        int size;
+
+        // Layers not handed out, most recently freed last
+        std::vector<int> freeLayers;
+    };
+
+    int layersPerArray;
+    std::vector<Array> arrays;
+};
@@ -0,0 +1,336 @@
+#include "texture_cache.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+// File header, followed by the packed mip chain. The key is repeated so a hash
+// collision on the file name is caught.
+struct TextureFileHeader
+{
+    char magic[4];
+    std::uint32_t format;
+    std::uint64_t key;
+    std::uint32_t width, height;
+    std::uint32_t levels, reserved;
+    std::uint64_t length;
+    std::uint64_t checksum;
+};
+static_assert(sizeof(TextureFileHeader) == 48, "the header is read straight from the file");
+
+const char textureMagic[4] = {'P', 'T', 'E', 'X'};
+const std::uint32_t textureFormat = 1;
+
+// FNV-1a, continued from a previous hash
+std::uint64_t hashBytes(const void *data, std::size_t size, std::uint64_t hash = 14695981039346656037ull)
+{
+    const unsigned char *bytes = (const unsigned char *)data;
+    for (std::size_t i = 0; i < size; i++)
+    {
+        hash = (hash ^ bytes[i]) * 1099511628211ull;
+    }
+    return hash;
+}
+
+// FNV-1a over 64-bit words instead of bytes, so checking an entry costs a
+// fraction of generating it. Every step is a bijection of the running hash, so
+// any single changed word changes the result.
+std::uint64_t checksum(const unsigned char *data, std::size_t size)
+{
+    std::uint64_t hash = 14695981039346656037ull;
+    std::size_t i = 0;
+    for (; i + 8 <= size; i += 8)
+    {
+        std::uint64_t word;
+        std::memcpy(&word, data + i, 8);
+        hash = (hash ^ word) * 1099511628211ull;
+    }
+    return hashBytes(data + i, size - i, hash);
+}
+}
+
+int mipLevelCount(int width, int height)
+{
+    int levels = 1;
+    while (width > 1 || height > 1)
+    {
+        width = std::max(1, width / 2);
+        height = std::max(1, height / 2);
+        levels++;
+    }
+    return levels;
+}
+
+std::vector<std::size_t> mipLevelOffsets(int width, int height)
+{
+    std::vector<std::size_t> offsets(1, 0);
+    for (int level = 0, levels = mipLevelCount(width, height); level < levels; level++)
+    {
+        offsets.push_back(offsets.back() + (std::size_t)width * height * 3);
+        width = std::max(1, width / 2);
+        height = std::max(1, height / 2);
+    }
+    return offsets;
+}
+
+void buildMipChain(int width, int height, unsigned char *chain)
+{
+    for (int level = 1, levels = mipLevelCount(width, height); level < levels; level++)
+    {
+        const unsigned char *source = chain;
+        chain += (std::size_t)width * height * 3;
+        int nextWidth = std::max(1, width / 2), nextHeight = std::max(1, height / 2);
+
+        for (int y = 0; y < nextHeight; y++)
+        {
+            const unsigned char *row0 = source + (std::size_t)std::min(2 * y, height - 1) * width * 3;
+            const unsigned char *row1 = source + (std::size_t)std::min(2 * y + 1, height - 1) * width * 3;
+            unsigned char *out = chain + (std::size_t)y * nextWidth * 3;
+            for (int x = 0; x < nextWidth; x++)
+            {
+                int x0 = std::min(2 * x, width - 1) * 3, x1 = std::min(2 * x + 1, width - 1) * 3;
+                for (int c = 0; c < 3; c++)
+                {
+                    out[3 * x + c] = (unsigned char)((row0[x0 + c] + row0[x1 + c] + row1[x0 + c] + row1[x1 + c] + 2) / 4);
+                }
+            }
+        }
+        width = nextWidth;
+        height = nextHeight;
+    }
+}
+
+MappedFile::MappedFile(const std::string &path)
+{
+#if defined(_WIN32)
+    file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING,
+                       FILE_ATTRIBUTE_NORMAL, nullptr);
+    LARGE_INTEGER fileSize;
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        file = nullptr;
+        return;
+    }
+    if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0)
+    {
+        return;
+    }
+    mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mapping)
+    {
+        bytes = (const unsigned char *)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+        length = bytes ? (std::size_t)fileSize.QuadPart : 0;
+    }
+#else
+    int descriptor = open(path.c_str(), O_RDONLY);
+    if (descriptor < 0)
+    {
+        return;
+    }
+    struct stat status;
+    if (fstat(descriptor, &status) == 0 && status.st_size > 0)
+    {
+        void *view = mmap(nullptr, (std::size_t)status.st_size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+        if (view != MAP_FAILED)
+        {
+            bytes = (const unsigned char *)view;
+            length = (std::size_t)status.st_size;
+        }
+    }
+    // The mapping keeps the file open
+    close(descriptor);
+#endif
+}
+
+MappedFile::~MappedFile()
+{
+#if defined(_WIN32)
+    if (bytes)
+    {
+        UnmapViewOfFile(bytes);
+    }
+    if (mapping)
+    {
+        CloseHandle(mapping);
+    }
+    if (file)
+    {
+        CloseHandle(file);
+    }
+#else
+    if (bytes)
+    {
+        munmap((void *)bytes, length);
+    }
+#endif
+}
+
+TextureCache::TextureCache(const std::string &directory, std::uint64_t maxBytes)
+    : directory(directory), maxBytes(maxBytes)
+{
+}
+
+std::uint64_t TextureCache::key(const char *generator, std::uint32_t version, const void *parameters,
+                                std::size_t parameterBytes, int width, int height)
+{
+    // The terminator is hashed too, so "ab" + parameters differs from "a" + "b..."
+    std::uint64_t hash = hashBytes(generator, std::strlen(generator) + 1);
+    hash = hashBytes(&version, sizeof(version), hash);
+    hash = hashBytes(parameters, parameterBytes, hash);
+    hash = hashBytes(&width, sizeof(width), hash);
+    return hashBytes(&height, sizeof(height), hash);
+}
+
+std::string TextureCache::path(std::uint64_t key) const
+{
+    char name[32];
+    std::snprintf(name, sizeof(name), "%016llx.ptex", (unsigned long long)key);
+    return (std::filesystem::path(directory) / name).string();
+}
+
+bool TextureCache::load(std::uint64_t key, int width, int height, MipChain &chain)
+{
+    std::string file = path(key);
+    std::shared_ptr<MappedFile> mapped = std::make_shared<MappedFile>(file);
+    if (mapped->size() == 0)
+    {
+        misses++;
+        return false;
+    }
+
+    std::vector<std::size_t> offsets = mipLevelOffsets(width, height);
+    TextureFileHeader header;
+    bool valid = mapped->size() >= sizeof(header);
+    if (valid)
+    {
+        std::memcpy(&header, mapped->data(), sizeof(header));
+        valid = std::memcmp(header.magic, textureMagic, 4) == 0 && header.format == textureFormat &&
+                header.key == key && header.width == (std::uint32_t)width && header.height == (std::uint32_t)height &&
+                header.levels == (std::uint32_t)(offsets.size() - 1) && header.length == offsets.back() &&
+                mapped->size() == sizeof(header) + header.length &&
+                checksum(mapped->data() + sizeof(header), (std::size_t)header.length) == header.checksum;
+    }
+
+    // Truncated by a full disk, damaged, or from another format: regenerate it
+    std::error_code ignored;
+    if (!valid)
+    {
+        mapped.reset();
+        std::filesystem::remove(file, ignored);
+        rejected++;
+        misses++;
+        return false;
+    }
+
+    // Mark the entry as recently used, for eviction
+    std::filesystem::last_write_time(file, std::filesystem::file_time_type::clock::now(), ignored);
+
+    chain.width = width;
+    chain.height = height;
+    chain.offsets = offsets;
+    chain.pixels.clear();
+    chain.mapping = mapped;
+    chain.mappingOffset = sizeof(header);
+    hits++;
+    return true;
+}
+
+void TextureCache::store(std::uint64_t key, const MipChain &chain)
+{
+    std::lock_guard<std::mutex> lock(storeMutex);
+    std::error_code error;
+    std::filesystem::create_directories(directory, error);
+
+    TextureFileHeader header;
+    std::memcpy(header.magic, textureMagic, 4);
+    header.format = textureFormat;
+    header.key = key;
+    header.width = (std::uint32_t)chain.width;
+    header.height = (std::uint32_t)chain.height;
+    header.levels = (std::uint32_t)chain.levels();
+    header.reserved = 0;
+    header.length = chain.offsets.back();
+    header.checksum = checksum(chain.data(), (std::size_t)header.length);
+
+    // Write to a temporary name first so a crash never leaves a truncated entry
+    std::string file = path(key);
+    std::string temporary = file + ".tmp";
+    {
+        std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+        if (!out || !out.write((const char *)&header, sizeof(header)) ||
+            !out.write((const char *)chain.data(), (std::streamsize)header.length))
+        {
+            std::cerr << "Could not write texture " << temporary << std::endl;
+            out.close();
+            std::filesystem::remove(temporary, error);
+            return;
+        }
+    }
+    std::filesystem::rename(temporary, file, error);
+    if (error)
+    {
+        std::filesystem::remove(temporary, error);
+        return;
+    }
+    evict();
+}
+
+void TextureCache::evict()
+{
+    struct Entry
+    {
+        std::filesystem::path path;
+        std::uint64_t size;
+        std::filesystem::file_time_type used;
+    };
+
+    std::vector<Entry> entries;
+    std::uint64_t total = 0;
+    std::error_code error;
+    for (const std::filesystem::directory_entry &item : std::filesystem::directory_iterator(directory, error))
+    {
+        std::error_code ignored;
+        if (item.path().extension() != ".ptex" || !item.is_regular_file(ignored))
+        {
+            continue;
+        }
+        Entry entry = {item.path(), (std::uint64_t)item.file_size(ignored), item.last_write_time(ignored)};
+        total += entry.size;
+        entries.push_back(entry);
+    }
+    if (total <= maxBytes)
+    {
+        return;
+    }
+
+    // Least recently used first
+    std::sort(entries.begin(), entries.end(), [](const Entry &a, const Entry &b) { return a.used < b.used; });
+    for (const Entry &entry : entries)
+    {
+        if (total <= maxBytes)
+        {
+            break;
+        }
+        if (std::filesystem::remove(entry.path, error))
+        {
+            total -= entry.size;
+            evicted++;
+        }
+    }
+}
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Number of mip levels of a width x height texture, halving down to 1x1
+int mipLevelCount(int width, int height);
+
+// Byte offset of each level in a tightly packed RGB8 mip chain; the extra last
+// entry is the size of the whole chain
+std::vector<std::size_t> mipLevelOffsets(int width, int height);
+
+// Fill levels 1 and up of a packed chain from level 0, averaging 2x2 blocks
+// (along a side that is already one texel, that texel is used twice)
+void buildMipChain(int width, int height, unsigned char *chain);
+
+// A file's bytes, read-only. Memory-mapped, so pages are read from the page
+// cache on demand and handed to the driver without a copy through the heap.
+class MappedFile
+{
+public:
+    // An empty mapping (size 0) if the file cannot be opened or is empty
+    explicit MappedFile(const std::string &path);
+    ~MappedFile();
+
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    const unsigned char *data() const { return bytes; }
+    std::size_t size() const { return length; }
+
+private:
+    const unsigned char *bytes = nullptr;
+    std::size_t length = 0;
+#if defined(_WIN32)
+    void *file = nullptr, *mapping = nullptr;
+#endif
+};
+
+// An RGB8 texture with its whole mip chain, packed as mipLevelOffsets()
+// describes. The pixels are either generated into this object or a view of a
+// mapped cache entry, which stays mapped while the chain lives.
+struct MipChain
+{
+    int width = 0, height = 0;
+    std::vector<std::size_t> offsets;
+
+    std::vector<unsigned char> pixels;
+    std::shared_ptr<MappedFile> mapping;
+    std::size_t mappingOffset = 0;
+
+    int levels() const { return (int)offsets.size() - 1; }
+    const unsigned char *data() const { return mapping ? mapping->data() + mappingOffset : pixels.data(); }
+    const unsigned char *level(int i) const { return data() + offsets[(std::size_t)i]; }
+};
+
+// Generated textures kept on disk, so later runs map them instead of generating
+// them again. An entry is content-addressed: its key hashes everything the
+// pixels depend on (generator, its version, its parameters and the size), so a
+// changed generator simply never finds its old entries. Files carry the key
+// and a checksum of the pixels; one that fails either is deleted and counted
+// as rejected. Entries used least recently are deleted once the directory
+// grows past maxBytes. Safe to call from several threads.
+class TextureCache
+{
+public:
+    // The directory is created on first store
+    explicit TextureCache(const std::string &directory, std::uint64_t maxBytes = 256ull << 20);
+
+    static std::uint64_t key(const char *generator, std::uint32_t version, const void *parameters,
+                             std::size_t parameterBytes, int width, int height);
+
+    // Map the entry into chain; false on a miss or a corrupt entry
+    bool load(std::uint64_t key, int width, int height, MipChain &chain);
+
+    // Write a chain built by buildMipChain(), then evict down to the size limit
+    void store(std::uint64_t key, const MipChain &chain);
+
+    // Entries loaded, looked up but absent, found corrupt, and evicted
+    std::atomic<std::size_t> hits{0}, misses{0}, rejected{0}, evicted{0};
+
+private:
+    std::string directory;
+    std::uint64_t maxBytes;
+
+    // Serializes writes and eviction
+    std::mutex storeMutex;
+
+    std::string path(std::uint64_t key) const;
+    void evict();
+};
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Procedural texture kernels, one set per instruction set, built like the belt
+// kernels (see belt_kernels.h). The patterns themselves are in
+// texture_patterns.h, which only the kernel files include, and draw on the
+// coherent noise in coherent_noise.h.
+
+// Texture patterns; procedural_texture.cpp maps body names to these
+enum class TexturePattern
+{
+    Sun,
+    Earth,
+    Mars,
+    Jupiter,
+    Saturn,
+    Uranus,
+    Neptune,
+
+    // Grey rock, for bodies without a pattern of their own
+    Rocky,
+
+    Count
+};
+
+// Bump whenever a pattern's output changes, so cached textures from the old
+// patterns are not found again (see TextureCache)
+const std::uint32_t textureGeneratorVersion = 2;
+
+// Rows [firstRow, endRow) of one width x height RGB8 texture, mapped
+// equirectangularly onto the body: u is longitude, v runs from pole to pole
+struct TextureKernelJob
+{
+    int width, height;
+    int firstRow, endRow;
+
+    // Seed of the texture's noise fields
+    std::uint32_t seed;
+
+    unsigned char *pixels;
+
+    // textureKernelScratchFloats(width) floats of working space
+    float *scratch;
+};
+
+static inline std::size_t textureKernelScratchFloats(int width)
+{
+    return (std::size_t)width * 6;
+}
+
+typedef void (*TextureKernel)(const TextureKernelJob &job);
+
+// Kernels indexed by TexturePattern; null when the file was built without the instruction set
+const TextureKernel *scalarTextureKernels();
+const TextureKernel *avx2TextureKernels();
+const TextureKernel *avx512TextureKernels();
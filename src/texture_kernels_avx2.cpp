@@ -0,0 +1,14 @@
+// Compiled with AVX2 and FMA enabled (see CMakeLists.txt)
+#include "texture_patterns.h"
+
+#if defined(__AVX2__)
+const TextureKernel *avx2TextureKernels()
+{
+    return textureKernelTable;
+}
+#else
+const TextureKernel *avx2TextureKernels()
+{
+    return nullptr;
+}
+#endif
@@ -0,0 +1,14 @@
+// Compiled with AVX-512F enabled (see CMakeLists.txt)
+#include "texture_patterns.h"
+
+#if defined(__AVX512F__)
+const TextureKernel *avx512TextureKernels()
+{
+    return textureKernelTable;
+}
+#else
+const TextureKernel *avx512TextureKernels()
+{
+    return nullptr;
+}
+#endif
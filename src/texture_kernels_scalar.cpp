@@ -0,0 +1,7 @@
+// Baseline build with the project's default flags (SSE2 on x86-64)
+#include "texture_patterns.h"
+
+const TextureKernel *scalarTextureKernels()
+{
+    return textureKernelTable;
+}
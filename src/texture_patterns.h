@@ -0,0 +1,271 @@
+#pragma once
+
+#include "coherent_noise.h"
+#include "kernel_math.h"
+#include "texture_kernels.h"
+
+// The texture patterns behind the kernels in texture_kernels.h. Every pattern
+// is a template instance of the same row loop, which splits the pattern into
+// terms of u alone (computed once per column), terms of v alone (once per row)
+// and a branch-free shading step per texel that the auto-vectorizer turns into
+// 8 (AVX2) or 16 (AVX-512) texels per iteration. Surfaces are shaded from
+// coherent noise sampled on the unit sphere under each texel, so they have no
+// seam at u = 0, no pinching at the poles and the same features at any
+// resolution. Everything is in an anonymous namespace, so each kernel file keeps
+// its own copies built with its own flags; like belt_kernels.h, this header
+// must stay free of standard library calls.
+
+namespace
+{
+static inline float sine(float x)
+{
+    float s, c;
+    sinCos(x, s, c);
+    return s;
+}
+
+static inline int clampByte(int value)
+{
+    return value > 255 ? 255 : value < 0 ? 0 : value;
+}
+
+// Patterns drawn on the sphere: columns hold the cosine and sine of the
+// longitude, rows the radius and height of the latitude circle, so the point
+// under a texel is (ring * a, height, ring * b)
+struct SphereRow
+{
+    float ring, height;
+    std::uint32_t seed;
+};
+
+struct SpherePattern
+{
+    typedef SphereRow Row;
+
+    static void columns(float u, float &a, float &b)
+    {
+        sinCos(u * 6.28318531f, b, a);
+    }
+
+    static Row row(float v, std::uint32_t seed)
+    {
+        Row row;
+        sinCos(v * 3.14159265f, row.ring, row.height);
+        row.seed = seed;
+        return row;
+    }
+};
+
+// Solar surface with granules and sunspots
+struct SunPattern : SpherePattern
+{
+    static void shade(const Row &row, float, float a, float b, int &red, int &green, int &blue)
+    {
+        float x = row.ring * a, y = row.height, z = row.ring * b;
+        float granule = fbm<4>(x * 24.0f, y * 24.0f, z * 24.0f, row.seed);
+        float sunspot = smoothStep(0.45f, 0.6f, fbm<3>(x * 2.0f, y * 2.0f, z * 2.0f, row.seed + 1000u));
+        red = (int)mix(255.0f, 150.0f, sunspot);
+        green = clampByte((int)mix(235.0f + granule * 30.0f, 110.0f, sunspot));
+        blue = clampByte((int)mix(165.0f + granule * 45.0f, 70.0f, sunspot));
+    }
+};
+
+// Oceans, continents with mountains and ice caps, and clouds. Height is
+// domain-warped fBm, which gives coastlines bays and peninsulas instead of blobs.
+struct EarthPattern : SpherePattern
+{
+    static void shade(const Row &row, float, float a, float b, int &red, int &green, int &blue)
+    {
+        float x = row.ring * a, y = row.height, z = row.ring * b;
+        float height = warpedFbm<8, 3>(x * 0.9f, y * 0.9f, z * 0.9f, 0.7f, row.seed);
+
+        // Depth shading below sea level, lowland green through highland brown to snow above
+        float shallow = smoothStep(-0.45f, 0.05f, height);
+        float highland = smoothStep(0.15f, 0.55f, height);
+        float snow = smoothStep(0.5f, 0.62f, height);
+        bool land = height > 0.05f;
+        float r = land ? mix(mix(55.0f, 125.0f, highland), 235.0f, snow) : mix(10.0f, 35.0f, shallow);
+        float g = land ? mix(mix(110.0f, 100.0f, highland), 235.0f, snow) : mix(30.0f, 95.0f, shallow);
+        float bl = land ? mix(mix(45.0f, 70.0f, highland), 240.0f, snow) : mix(90.0f, 165.0f, shallow);
+
+        // Polar ice, its edge roughened by the height field
+        float ice = smoothStep(0.95f, 0.97f, (y < 0.0f ? -y : y) + height * 0.05f);
+        r = mix(r, 230.0f, ice);
+        g = mix(g, 236.0f, ice);
+        bl = mix(bl, 242.0f, ice);
+
+        // Clouds, stretched along the latitude circles like weather systems
+        float cloud = smoothStep(0.1f, 0.55f, fbm<5>(x * 3.0f, y * 6.0f, z * 3.0f, row.seed + 2000u)) * 0.9f;
+        red = (int)mix(r, 240.0f, cloud);
+        green = (int)mix(g, 240.0f, cloud);
+        blue = (int)mix(bl, 240.0f, cloud);
+    }
+};
+
+// Red dust with darker plains, canyons and small polar caps
+struct MarsPattern : SpherePattern
+{
+    static void shade(const Row &row, float, float a, float b, int &red, int &green, int &blue)
+    {
+        float x = row.ring * a, y = row.height, z = row.ring * b;
+        float dust = fbm<6>(x * 2.5f, y * 2.5f, z * 2.5f, row.seed) * 0.5f + 0.5f;
+        float canyon = smoothStep(0.6f, 0.9f, ridged<4>(x * 2.0f, y * 2.0f, z * 2.0f, row.seed + 3000u));
+        float tone = dust * (1.0f - 0.45f * canyon);
+        float cap = smoothStep(0.975f, 0.985f, (y < 0.0f ? -y : y) + dust * 0.01f);
+        red = (int)mix(110.0f + tone * 110.0f, 225.0f, cap);
+        green = (int)mix(45.0f + tone * 55.0f, 220.0f, cap);
+        blue = (int)mix(20.0f + tone * 35.0f, 215.0f, cap);
+    }
+};
+
+// Light and dark bands, their edges churned by turbulence, and the Great Red Spot
+struct JupiterPattern : SpherePattern
+{
+    struct Row : SphereRow
+    {
+        float v;
+
+        // Squared distance from the spot's centre along v
+        float spotDistance2;
+    };
+
+    static Row row(float v, std::uint32_t seed)
+    {
+        Row row;
+        static_cast<SphereRow &>(row) = SpherePattern::row(v, seed);
+        row.v = v;
+        row.spotDistance2 = (v - 0.5f) * (v - 0.5f);
+        return row;
+    }
+
+    static void shade(const Row &row, float u, float a, float b, int &red, int &green, int &blue)
+    {
+        float x = row.ring * a, y = row.height, z = row.ring * b;
+        float turbulence = fbm<4>(x * 3.0f, y * 9.0f, z * 3.0f, row.seed);
+        float band = smoothStep(-0.6f, 0.6f, sine(row.v * 20.0f + turbulence * 1.2f)) + turbulence * 0.3f;
+        float spotDistance2 = (u - 0.7f) * (u - 0.7f) + row.spotDistance2;
+        float spot = 1.0f - smoothStep(0.08f * 0.08f, 0.1f * 0.1f, spotDistance2 + turbulence * 0.0015f);
+        red = (int)mix(mix(160.0f, 205.0f, band), 180.0f, spot);
+        green = (int)mix(mix(100.0f, 155.0f, band), 80.0f, spot);
+        blue = (int)mix(mix(60.0f, 105.0f, band), 60.0f, spot);
+    }
+};
+
+// Bands that vary only with latitude, so a whole row is one colour
+struct BandPattern
+{
+    struct Row
+    {
+        int red, green, blue;
+    };
+
+    static void columns(float, float &a, float &b)
+    {
+        a = b = 0.0f;
+    }
+
+    static void shade(const Row &row, float, float, float, int &red, int &green, int &blue)
+    {
+        red = row.red;
+        green = row.green;
+        blue = row.blue;
+    }
+};
+
+// Pale bands
+struct SaturnPattern : BandPattern
+{
+    static Row row(float v, std::uint32_t)
+    {
+        float band = sine(v * 15) * 0.3f + 0.7f;
+        return {200 + (int)(band * 30), 180 + (int)(band * 20), 140 + (int)(band * 20)};
+    }
+};
+
+// Pale blue-green with subtle bands
+struct UranusPattern : BandPattern
+{
+    static Row row(float v, std::uint32_t)
+    {
+        float band = sine(v * 10) * 0.2f + 0.8f;
+        return {120 + (int)(band * 20), 160 + (int)(band * 30), 180 + (int)(band * 20)};
+    }
+};
+
+// Deep blue with streaks of white cloud
+struct NeptunePattern : SpherePattern
+{
+    static void shade(const Row &row, float, float a, float b, int &red, int &green, int &blue)
+    {
+        float x = row.ring * a, y = row.height, z = row.ring * b;
+        float haze = fbm<3>(x * 2.0f, y * 5.0f, z * 2.0f, row.seed) * 0.5f + 0.5f;
+        float cloud = smoothStep(0.2f, 0.5f, fbm<4>(x * 2.0f, y * 10.0f, z * 2.0f, row.seed + 4000u));
+        red = (int)mix(45.0f + haze * 30.0f, 215.0f, cloud);
+        green = (int)mix(80.0f + haze * 45.0f, 220.0f, cloud);
+        blue = (int)mix(165.0f + haze * 55.0f, 235.0f, cloud);
+    }
+};
+
+// Grey rock: mottled fBm with bright ridges
+struct RockyPattern : SpherePattern
+{
+    static void shade(const Row &row, float, float a, float b, int &red, int &green, int &blue)
+    {
+        float x = row.ring * a, y = row.height, z = row.ring * b;
+        float mottle = fbm<5>(x * 3.0f, y * 3.0f, z * 3.0f, row.seed);
+        float ridge = ridged<3>(x * 5.0f, y * 5.0f, z * 5.0f, row.seed + 5000u);
+        red = green = blue = clampByte(135 + (int)(mottle * 60.0f) + (int)(ridge * 50.0f));
+    }
+};
+
+// The loop every kernel file instantiates for every pattern
+template <typename Pattern>
+void generateTexture(const TextureKernelJob &job)
+{
+    const int width = job.width;
+    float *__restrict u = job.scratch;
+    float *__restrict columnA = u + width;
+    float *__restrict columnB = columnA + width;
+    // Channels stay ints until the final loop packs them: AVX-512F has no byte vectors
+    int *__restrict red = (int *)(columnB + width);
+    int *__restrict green = red + width;
+    int *__restrict blue = green + width;
+
+    for (int x = 0; x < width; x++)
+    {
+        u[x] = (float)x / width;
+        Pattern::columns(u[x], columnA[x], columnB[x]);
+    }
+
+    for (int y = job.firstRow; y < job.endRow; y++)
+    {
+        float v = (float)y / job.height;
+        const typename Pattern::Row row = Pattern::row(v, job.seed);
+
+        for (int x = 0; x < width; x++)
+        {
+            Pattern::shade(row, u[x], columnA[x], columnB[x], red[x], green[x], blue[x]);
+        }
+
+        unsigned char *__restrict out = job.pixels + (std::size_t)y * width * 3;
+        for (int x = 0; x < width; x++)
+        {
+            out[3 * x] = (unsigned char)red[x];
+            out[3 * x + 1] = (unsigned char)green[x];
+            out[3 * x + 2] = (unsigned char)blue[x];
+        }
+    }
+}
+
+// Every pattern's kernel in TexturePattern order, as built by the including file
+static const TextureKernel textureKernelTable[(int)TexturePattern::Count] = {
+    generateTexture<SunPattern>,
+    generateTexture<EarthPattern>,
+    generateTexture<MarsPattern>,
+    generateTexture<JupiterPattern>,
+    generateTexture<SaturnPattern>,
+    generateTexture<UranusPattern>,
+    generateTexture<NeptunePattern>,
+    generateTexture<RockyPattern>,
+};
+}
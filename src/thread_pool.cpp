@@ -0,0 +1,117 @@
+#include "thread_pool.h"
+
+#include <algorithm>
+#include <atomic>
+
+ThreadPool::ThreadPool(unsigned threadCount)
+{
+    if (threadCount == 0)
+    {
+        threadCount = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    // The caller counts as one of the threads
+    for (unsigned i = 1; i < threadCount; i++)
+    {
+        workers.emplace_back(&ThreadPool::workerLoop, this);
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    available.notify_all();
+
+    for (auto &worker : workers)
+    {
+        worker.join();
+    }
+}
+
+void ThreadPool::enqueue(std::function<void()> task)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        tasks.push(std::move(task));
+    }
+    available.notify_one();
+}
+
+void ThreadPool::workerLoop()
+{
+    for (;;)
+    {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            available.wait(lock, [this]() { return stopping || !tasks.empty(); });
+            if (stopping && tasks.empty())
+            {
+                return;
+            }
+            task = std::move(tasks.front());
+            tasks.pop();
+        }
+        task();
+    }
+}
+
+void ThreadPool::parallelFor(std::size_t count, std::size_t minChunk,
+                             const std::function<void(std::size_t, std::size_t)> &fn)
+{
+    if (count == 0)
+    {
+        return;
+    }
+
+    minChunk = std::max<std::size_t>(minChunk, 1);
+    std::size_t chunkCount = std::min<std::size_t>((count + minChunk - 1) / minChunk, (std::size_t)size() * 4);
+
+    // Not worth waking anyone up
+    if (chunkCount <= 1 || workers.empty())
+    {
+        fn(0, count);
+        return;
+    }
+
+    std::size_t chunkSize = (count + chunkCount - 1) / chunkCount;
+
+    struct Shared
+    {
+        std::atomic<std::size_t> next{0};
+        std::atomic<std::size_t> done{0};
+        std::mutex mutex;
+        std::condition_variable finished;
+    };
+    auto shared = std::make_shared<Shared>();
+
+    // Helpers and the caller pull chunks until none are left
+    auto run = [shared, chunkCount, chunkSize, count, &fn]()
+    {
+        std::size_t chunk;
+        while ((chunk = shared->next.fetch_add(1)) < chunkCount)
+        {
+            std::size_t begin = chunk * chunkSize;
+            std::size_t end = std::min(begin + chunkSize, count);
+            fn(begin, end);
+            if (shared->done.fetch_add(1) + 1 == chunkCount)
+            {
+                std::lock_guard<std::mutex> lock(shared->mutex);
+                shared->finished.notify_all();
+            }
+        }
+    };
+
+    std::size_t helpers = std::min<std::size_t>(workers.size(), chunkCount - 1);
+    for (std::size_t i = 0; i < helpers; i++)
+    {
+        enqueue(run);
+    }
+    run();
+
+    std::unique_lock<std::mutex> lock(shared->mutex);
+    shared->finished.wait(lock, [&]() { return shared->done.load() == chunkCount; });
+}
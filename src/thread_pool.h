@@ -0,0 +1,54 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+// Fixed-size pool of worker threads shared by the simulation and loaders.
+// The calling thread also executes work inside parallelFor, so nested calls
+// from a worker cannot deadlock.
+class ThreadPool
+{
+public:
+    // A thread count of 0 uses one thread per hardware core
+    explicit ThreadPool(unsigned threadCount = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    // Number of threads that share work in parallelFor, including the caller
+    unsigned size() const { return (unsigned)workers.size() + 1; }
+
+    // Split [0, count) into chunks of at least minChunk items and run
+    // fn(begin, end) on them in parallel. Blocks until every chunk is done.
+    void parallelFor(std::size_t count, std::size_t minChunk,
+                     const std::function<void(std::size_t, std::size_t)> &fn);
+
+    // Queue a task and return a future for its result
+    template <typename F>
+    auto submit(F &&task) -> std::future<decltype(task())>
+    {
+        using Result = decltype(task());
+        auto packaged = std::make_shared<std::packaged_task<Result()>>(std::forward<F>(task));
+        std::future<Result> result = packaged->get_future();
+        enqueue([packaged]() { (*packaged)(); });
+        return result;
+    }
+
+private:
+    std::vector<std::thread> workers;
+    std::queue<std::function<void()>> tasks;
+    std::mutex mutex;
+    std::condition_variable available;
+    bool stopping = false;
+
+    void enqueue(std::function<void()> task);
+    void workerLoop();
+};
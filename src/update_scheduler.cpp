@@ -0,0 +1,56 @@
+#include "update_scheduler.h"
+
+// Below these sizes the cost of waking workers outweighs the work itself
+static const std::size_t angleChunk = 16384;
+static const std::size_t matrixChunk = 2048;
+static const std::size_t keplerChunk = 1024;
+
+UpdateScheduler::UpdateScheduler(ThreadPool &pool) : pool(pool)
+{
+}
+
+void UpdateScheduler::build(const BodyStore &store)
+{
+    levels.clear();
+    for (std::size_t i = 0; i < store.size(); i++)
+    {
+        std::size_t d = (std::size_t)store.depth[i];
+        if (d >= levels.size())
+        {
+            levels.resize(d + 1);
+        }
+        levels[d].push_back((int)i);
+    }
+    builtSize = store.size();
+}
+
+void UpdateScheduler::tick(BodyStore &store, float deltaTime)
+{
+    if (builtSize != store.size())
+    {
+        build(store);
+    }
+
+    // Each body's angles advance exactly once, in disjoint chunks
+    store.simulationTime += deltaTime;
+    pool.parallelFor(store.size(), angleChunk, [&](std::size_t begin, std::size_t end)
+                     { store.updateRange(deltaTime, begin, end); });
+
+    // Elliptical orbits are evaluated directly at the new time
+    pool.parallelFor(store.keplerOrbits.size(), keplerChunk, [&](std::size_t begin, std::size_t end)
+                     { store.keplerOrbits.evaluate(store.simulationTime, begin, end); });
+
+    // A level only reads matrices from the level above, which is already complete
+    for (const auto &bodiesAtDepth : levels)
+    {
+        const int *indices = bodiesAtDepth.data();
+        pool.parallelFor(bodiesAtDepth.size(), matrixChunk, [&](std::size_t begin, std::size_t end)
+                         { store.updateWorldMatrices(indices + begin, end - begin); });
+    }
+}
+
+void UpdateScheduler::rebase(BodyStore &store, const glm::dvec3 &origin)
+{
+    pool.parallelFor(store.size(), matrixChunk, [&](std::size_t begin, std::size_t end)
+                     { store.rebaseRange(origin, begin, end); });
+}
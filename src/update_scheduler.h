@@ -0,0 +1,34 @@
+#pragma once
+
+#include "body_store.h"
+#include "thread_pool.h"
+
+#include <vector>
+
+// Advances a BodyStore once per tick. Angle updates are independent per body
+// and run as one parallel sweep; world matrices depend on the parent, so they
+// are computed level by level (all depth-0 bodies, then depth 1, ...) with
+// each level's bodies split across the pool.
+class UpdateScheduler
+{
+public:
+    explicit UpdateScheduler(ThreadPool &pool);
+
+    // Group the store's bodies by hierarchy depth. tick() calls this
+    // automatically when bodies have been added since the last build.
+    void build(const BodyStore &store);
+
+    // Advance every body exactly once and refresh every world matrix exactly once
+    void tick(BodyStore &store, float deltaTime);
+
+    // Refresh every render matrix relative to origin (the camera), once per frame after tick()
+    void rebase(BodyStore &store, const glm::dvec3 &origin);
+
+    std::size_t levelCount() const { return levels.size(); }
+    const AlignedVector<int> &level(std::size_t depth) const { return levels[depth]; }
+
+private:
+    ThreadPool &pool;
+    std::vector<AlignedVector<int>> levels;
+    std::size_t builtSize = 0;
+};